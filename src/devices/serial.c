@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -37,6 +37,13 @@
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
 
+/* Interrupt Identification Register bits. */
+#define IIR_FIFO 0xc0           /* FIFOs enabled. */
+
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable the receive and transmit FIFOs. */
+#define FCR_CLEAR 0x06          /* Clear both FIFOs. */
+
 /* Line Control Register bits. */
 #define LCR_N81 0x03            /* No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80           /* Divisor Latch Access Bit (DLAB). */
@@ -48,17 +55,52 @@
 #define LSR_DR 0x01             /* Data Ready: received data byte is in RBR. */
 #define LSR_THRE 0x20           /* THR Empty. */
 
+/* Bytes the 16550A's transmit FIFO holds. */
+#define FIFO_SIZE 16
+
+/* Bytes to send per transmit interrupt: FIFO_SIZE, or 1 if the
+   UART turns out to have no FIFO. */
+static int tx_burst = 1;
+
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted, in a ring buffer that writers fill and
+   the serial interrupt drains.  TX_HEAD and TX_TAIL count the
+   bytes ever put in and taken out, so the buffer holds TX_HEAD -
+   TX_TAIL bytes.  A writer that finds it full sleeps on TX_ROOM
+   until the interrupt handler has emptied half of it. */
+#define TXQ_SIZE 4096           /* Power of 2. */
+static uint8_t txq[TXQ_SIZE];
+static size_t tx_head, tx_tail;
+static struct semaphore tx_room;
+static int tx_waiters;          /* Threads sleeping on TX_ROOM. */
+
+/* Last value written to the interrupt enable register. */
+static uint8_t ier_value;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
+static void wake_writers (void);
 static intr_handler_func serial_interrupt;
 
+/* Returns the number of bytes waiting to be transmitted. */
+static inline size_t
+txq_used (void) 
+{
+  return tx_head - tx_tail;
+}
+
+/* Removes and returns the oldest byte waiting to be
+   transmitted. */
+static inline uint8_t
+txq_get (void) 
+{
+  ASSERT (txq_used () > 0);
+  return txq[tx_tail++ % TXQ_SIZE];
+}
+
 /* Initializes the serial port device for polling mode.
    Polling mode busy-waits for the serial port to become free
    before writing to it.  It's slow, but until interrupts have
@@ -71,7 +113,7 @@ init_poll (void)
   outb (FCR_REG, 0);                    /* Disable FIFO. */
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
+  sema_init (&tx_room, 0);
   mode = POLL;
 } 
 
@@ -87,6 +129,12 @@ serial_init_queue (void)
     init_poll ();
   ASSERT (mode == POLL);
 
+  /* With the FIFOs on, each transmit interrupt can send
+     FIFO_SIZE bytes instead of one. */
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR);
+  if ((inb (IIR_REG) & IIR_FIFO) == IIR_FIFO)
+    tx_burst = FIFO_SIZE;
+
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
   mode = QUEUE;
   old_level = intr_disable ();
@@ -98,33 +146,64 @@ serial_init_queue (void)
 void
 serial_putc (uint8_t byte) 
 {
+  serial_write (&byte, 1);
+}
+
+/* Sends the SIZE bytes in BUFFER to the serial port.  Once the
+   port is interrupt-driven, this only copies them into the
+   transmit queue, and sleeps only if the queue fills up. */
+void
+serial_write (const void *buffer, size_t size) 
+{
+  const uint8_t *p = buffer;
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (size-- > 0)
+        putc_poll (*p++); 
     }
   else 
-    {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
-        {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
-        }
-
-      intq_putc (&txq, byte); 
-      write_ier ();
-    }
+    while (size > 0)
+      {
+        size_t ofs = tx_head % TXQ_SIZE;
+        size_t chunk = TXQ_SIZE - txq_used ();
+
+        if (chunk == 0)
+          {
+            if (old_level == INTR_OFF) 
+              {
+                /* Interrupts are off and the transmit queue is
+                   full.  If we wanted to wait for the queue to
+                   empty, we'd have to reenable interrupts.
+                   That's impolite, so we'll send a character via
+                   polling instead. */
+                putc_poll (txq_get ()); 
+              }
+            else
+              {
+                tx_waiters++;
+                sema_down (&tx_room);
+              }
+            continue;
+          }
+
+        /* Queue as much as fits before the end of the buffer,
+           then update the interrupt enable register. */
+        if (chunk > TXQ_SIZE - ofs)
+          chunk = TXQ_SIZE - ofs;
+        if (chunk > size)
+          chunk = size;
+        memcpy (txq + ofs, p, chunk);
+        tx_head += chunk;
+        p += chunk;
+        size -= chunk;
+        write_ier ();
+      }
   
   intr_set_level (old_level);
 }
@@ -135,8 +214,9 @@ void
 serial_flush (void) 
 {
   enum intr_level old_level = intr_disable ();
-  while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+  while (txq_used () > 0)
+    putc_poll (txq_get ());
+  wake_writers ();
   intr_set_level (old_level);
 }
 
@@ -182,7 +262,7 @@ write_ier (void)
 
   /* Enable transmit interrupt if we have any characters to
      transmit. */
-  if (!intq_empty (&txq))
+  if (txq_used () > 0)
     ier |= IER_XMIT;
 
   /* Enable receive interrupt if we have room to store any
@@ -190,7 +270,25 @@ write_ier (void)
   if (!input_full ())
     ier |= IER_RECV;
   
-  outb (IER_REG, ier);
+  /* Port I/O is slow, especially under a virtual machine, so
+     skip the write if nothing changed. */
+  if (ier != ier_value)
+    {
+      outb (IER_REG, ier);
+      ier_value = ier;
+    }
+}
+
+/* Wakes the threads waiting for room in the transmit queue, if
+   at least half of it is free. */
+static void
+wake_writers (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (txq_used () <= TXQ_SIZE / 2)
+    for (; tx_waiters > 0; tx_waiters--)
+      sema_up (&tx_room);
 }
 
 /* Polls the serial port until it's ready,
@@ -218,10 +316,16 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* If the hardware is ready to accept bytes for transmission,
+     fill its FIFO from the queue. */
+  if ((inb (LSR_REG) & LSR_THRE) != 0) 
+    {
+      int i;
+
+      for (i = 0; i < tx_burst && txq_used () > 0; i++)
+        outb (THR_REG, txq_get ());
+      wake_writers ();
+    }
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
@@ -4,8 +4,15 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/idle.h"
 #include "threads/io.h"
+#include "threads/malloc.h"
+#include "threads/memtag.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
@@ -120,6 +127,12 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  idle_print_stats ();
+  workqueue_print_stats ();
+  palloc_print_stats ();
+  malloc_print_stats ();
+  memtag_print_stats ();
+  slab_print_stats ();
 #ifdef FILESYS
   block_print_stats ();
 #endif
@@ -128,4 +141,5 @@ print_stats (void)
 #ifdef USERPROG
   exception_print_stats ();
 #endif
+  synch_print_profile ();
 }
@@ -7,6 +7,7 @@
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
   
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -16,10 +17,17 @@
 #if TIMER_FREQ > 1000
 #error TIMER_FREQ <= 1000 recommended
 #endif
+#if TIMER_FREQ / TIMER_IDLE_STRIDE < 19
+#error 8254 timer requires TIMER_FREQ / TIMER_IDLE_STRIDE >= 19
+#endif
 
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Number of ticks each timer interrupt stands for: 1 normally,
+   TIMER_IDLE_STRIDE while slowed down by timer_slow_down(). */
+static unsigned tick_stride = 1;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -159,6 +167,44 @@ timer_ndelay (int64_t ns)
   real_time_delay (ns, 1000 * 1000 * 1000);
 }
 
+/* Slows the timer interrupt down by a factor of
+   TIMER_IDLE_STRIDE, so that an idle CPU is woken up less often.
+   The tick count keeps advancing at the usual rate.  Must be
+   called with interrupts off, and undone with timer_speed_up()
+   before any thread other than the idle thread runs. */
+void
+timer_slow_down (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (tick_stride == 1)
+    {
+      tick_stride = TIMER_IDLE_STRIDE;
+      pit_configure_channel (0, 2, TIMER_FREQ / TIMER_IDLE_STRIDE);
+    }
+}
+
+/* Restores the normal timer rate after timer_slow_down().  The
+   whole ticks that went by in the partial slow period are
+   credited to the tick count.  Must be called with interrupts
+   off. */
+void
+timer_speed_up (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (tick_stride != 1)
+    {
+      unsigned period = PIT_HZ / (TIMER_FREQ / TIMER_IDLE_STRIDE);
+      unsigned left = pit_read_channel (0);
+      if (left != 0 && left <= period)
+        ticks += (int64_t) (period - left) * TIMER_FREQ / PIT_HZ;
+
+      tick_stride = 1;
+      pit_configure_channel (0, 2, TIMER_FREQ);
+    }
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) 
@@ -170,8 +216,12 @@ timer_print_stats (void)
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
-  ticks++;
-  thread_tick ();
+  unsigned i;
+
+  ticks += tick_stride;
+  for (i = 0; i < tick_stride; i++)
+    thread_tick ();
+  workqueue_tick (ticks);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -7,6 +7,11 @@
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* While the CPU is idle the timer is slowed down so that each
+   interrupt stands for this many ticks.  TIMER_FREQ divided by
+   this value must still be at least 19 Hz. */
+#define TIMER_IDLE_STRIDE 5
+
 void timer_init (void);
 void timer_calibrate (void);
 
@@ -24,6 +29,10 @@ void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
 void timer_ndelay (int64_t nanoseconds);
 
+/* Dynamic ticks. */
+void timer_slow_down (void);
+void timer_speed_up (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
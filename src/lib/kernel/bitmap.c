@@ -28,6 +28,7 @@ struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    size_t hint;        /* Where bitmap_alloc_run() searches first. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -60,6 +61,78 @@ byte_cnt (size_t bit_cnt)
   return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns a mask of the bits in element number IDX that
+   represent bits START through END - 1 of a bitmap.  The element
+   must overlap that range. */
+static inline elem_type
+range_mask (size_t idx, size_t start, size_t end) 
+{
+  size_t first = idx * ELEM_BITS;
+  size_t lo = start > first ? start - first : 0;
+  size_t hi = end < first + ELEM_BITS ? end - first : ELEM_BITS;
+  elem_type mask = hi - lo < ELEM_BITS
+                   ? ((elem_type) 1 << (hi - lo)) - 1 : (elem_type) -1;
+  return mask << lo;
+}
+
+/* Returns the number of 1-bits in X. */
+static inline size_t
+popcount (elem_type x) 
+{
+  /* Count bits in pairs, then nibbles, then sum the bytes with a
+     multiply.  The kernel doesn't link against libgcc, which
+     __builtin_popcountl() might call. */
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0f0f0f0f;
+  return (x * 0x01010101) >> 24;
+}
+
+/* Returns the index of the lowest 1-bit in X, which must be
+   nonzero, using the BSF instruction. */
+static inline size_t
+lowest_bit (elem_type x) 
+{
+  elem_type bit;
+
+  asm ("bsfl %1, %0" : "=r" (bit) : "rm" (x) : "cc");
+  return bit;
+}
+
+/* Returns the element numbered IDX in B with every bit inverted
+   if VALUE is false, so that bits set to VALUE read as 1. */
+static inline elem_type
+elem_matching (const struct bitmap *b, size_t idx, bool value) 
+{
+  return value ? b->bits[idx] : ~b->bits[idx];
+}
+
+/* Returns the index of the first bit at or after START in B that
+   is set to VALUE, or the size of B if there is none. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) 
+{
+  size_t idx = elem_idx (start);
+  size_t last_idx = elem_cnt (b->bit_cnt);
+  elem_type bits;
+  size_t bit_idx;
+
+  if (start >= b->bit_cnt)
+    return b->bit_cnt;
+
+  bits = elem_matching (b, idx, value) & range_mask (idx, start, b->bit_cnt);
+  while (bits == 0)
+    {
+      if (++idx >= last_idx)
+        return b->bit_cnt;
+      bits = elem_matching (b, idx, value);
+    }
+
+  /* The unused bits in the last element may read as 1. */
+  bit_idx = idx * ELEM_BITS + lowest_bit (bits);
+  return bit_idx < b->bit_cnt ? bit_idx : b->bit_cnt;
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -83,6 +156,7 @@ bitmap_create (size_t bit_cnt)
     {
       b->bit_cnt = bit_cnt;
       b->bits = malloc (byte_cnt (bit_cnt));
+      b->hint = 0;
       if (b->bits != NULL || bit_cnt == 0)
         {
           bitmap_set_all (b, false);
@@ -105,6 +179,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  b->hint = 0;
   bitmap_set_all (b, false);
   return b;
 }
@@ -218,14 +293,23 @@ bitmap_set_all (struct bitmap *b, bool value)
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
+  size_t end = start + cnt;
+  size_t idx;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  /* Set a whole element at a time.  Each element is updated
+     atomically, as in bitmap_mark() and bitmap_reset(). */
+  for (idx = elem_idx (start); cnt > 0 && idx * ELEM_BITS < end; idx++)
+    {
+      elem_type mask = range_mask (idx, start, end);
+      if (value)
+        asm ("orl %1, %0" : "+m" (b->bits[idx]) : "r" (mask) : "cc");
+      else
+        asm ("andl %1, %0" : "+m" (b->bits[idx]) : "r" (~mask) : "cc");
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -233,16 +317,17 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i, value_cnt;
+  size_t end = start + cnt;
+  size_t idx, value_cnt;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
+  for (idx = elem_idx (start); cnt > 0 && idx * ELEM_BITS < end; idx++)
+    value_cnt += popcount (elem_matching (b, idx, value)
+                           & range_mask (idx, start, end));
   return value_cnt;
 }
 
@@ -251,14 +336,15 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
+  size_t end = start + cnt;
+  size_t idx;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
+  for (idx = elem_idx (start); cnt > 0 && idx * ELEM_BITS < end; idx++)
+    if ((elem_matching (b, idx, value) & range_mask (idx, start, end)) != 0)
       return true;
   return false;
 }
@@ -299,13 +385,22 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
-  if (cnt <= b->bit_cnt) 
+  if (cnt == 0)
+    return start;
+
+  /* Jump from the start of each run of VALUE bits to its end,
+     a word at a time, until a run is long enough. */
+  while (start + cnt <= b->bit_cnt) 
     {
-      size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t end;
+
+      start = find_next (b, start, value);
+      if (start + cnt > b->bit_cnt)
+        break;
+      end = find_next (b, start, !value);
+      if (end - start >= cnt)
+        return start;
+      start = end;
     }
   return BITMAP_ERROR;
 }
@@ -326,6 +421,33 @@ bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value)
   return idx;
 }
 
+/* Finds a group of CNT consecutive false bits in B, sets them
+   all to true, and returns the index of the first bit in the
+   group.  If there is no such group, returns BITMAP_ERROR.
+
+   The search starts just past the group found by the previous
+   call, wrapping around to the beginning of B if necessary, so
+   that on a large, mostly full bitmap each call need not scan
+   the full prefix that earlier calls filled. */
+size_t
+bitmap_alloc_run (struct bitmap *b, size_t cnt) 
+{
+  size_t idx = BITMAP_ERROR;
+
+  ASSERT (b != NULL);
+
+  if (b->hint < b->bit_cnt)
+    idx = bitmap_scan (b, b->hint, cnt, false);
+  if (idx == BITMAP_ERROR)
+    idx = bitmap_scan (b, 0, cnt, false);
+  if (idx != BITMAP_ERROR) 
+    {
+      bitmap_set_multiple (b, idx, cnt, true);
+      b->hint = idx + cnt;
+    }
+  return idx;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
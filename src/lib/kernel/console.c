@@ -59,11 +59,17 @@ static int console_lock_depth;
 /* Number of characters written to console. */
 static int64_t write_cnt;
 
+/* If true (default), console output goes to the vga display as
+   well as the serial port.
+   Controlled by kernel command-line option "-novga". */
+bool console_vga = true;
+
 /* Enable console locking. */
 void
 console_init (void) 
 {
   lock_init (&console_lock);
+  lock_set_name (&console_lock, "console");
   use_console_lock = true;
 }
 
@@ -83,8 +89,10 @@ console_print_stats (void)
   printf ("Console: %lld characters output\n", write_cnt);
 }
 
-/* Acquires the console lock. */
-static void
+/* Acquires the console lock.  Code outside this file may take
+   it around a series of writes to keep other threads' output
+   from landing in the middle. */
+void
 acquire_console (void) 
 {
   if (!intr_context () && use_console_lock) 
@@ -97,7 +105,7 @@ acquire_console (void)
 }
 
 /* Releases the console lock. */
-static void
+void
 release_console (void) 
 {
   if (!intr_context () && use_console_lock) 
@@ -148,13 +156,16 @@ puts (const char *s)
   return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console, handing
+   them to each device in one call. */
 void
 putbuf (const char *buffer, size_t n) 
 {
   acquire_console ();
-  while (n-- > 0)
-    putchar_have_lock (*buffer++);
+  write_cnt += n;
+  serial_write (buffer, n);
+  if (console_vga)
+    vga_write (buffer, n);
   release_console ();
 }
 
@@ -187,5 +198,6 @@ putchar_have_lock (uint8_t c)
   ASSERT (console_locked_by_current_thread ());
   write_cnt++;
   serial_putc (c);
-  vga_putc (c);
+  if (console_vga)
+    vga_putc (c);
 }
@@ -1,8 +1,17 @@
 #ifndef __LIB_KERNEL_CONSOLE_H
 #define __LIB_KERNEL_CONSOLE_H
 
+#include <stdbool.h>
+
+/* If true (default), console output goes to the vga display as
+   well as the serial port.
+   Controlled by kernel command-line option "-novga". */
+extern bool console_vga;
+
 void console_init (void);
 void console_panic (void);
 void console_print_stats (void);
+void acquire_console (void);
+void release_console (void);
 
 #endif /* lib/kernel/console.h */
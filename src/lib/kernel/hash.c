@@ -18,6 +18,8 @@ static struct hash_elem *find_elem (struct hash *, struct list *,
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
 static void remove_elem (struct hash *, struct hash_elem *);
 static void rehash (struct hash *);
+static void migrate (struct hash *);
+static struct list *next_bucket (struct hash *, struct list *);
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -28,6 +30,7 @@ hash_init (struct hash *h,
   h->elem_cnt = 0;
   h->bucket_cnt = 4;
   h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+  h->old_buckets = NULL;
   h->hash = hash;
   h->less = less;
   h->aux = aux;
@@ -53,11 +56,10 @@ hash_init (struct hash *h,
 void
 hash_clear (struct hash *h, hash_action_func *destructor) 
 {
-  size_t i;
+  struct list *bucket;
 
-  for (i = 0; i < h->bucket_cnt; i++) 
+  for (bucket = h->buckets; bucket != NULL; bucket = next_bucket (h, bucket))
     {
-      struct list *bucket = &h->buckets[i];
 
       if (destructor != NULL) 
         while (!list_empty (bucket)) 
@@ -70,6 +72,9 @@ hash_clear (struct hash *h, hash_action_func *destructor)
       list_init (bucket); 
     }    
 
+  /* Abandon any resize in progress. */
+  free (h->old_buckets);
+  h->old_buckets = NULL;
   h->elem_cnt = 0;
 }
 
@@ -88,6 +93,7 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
 {
   if (destructor != NULL)
     hash_clear (h, destructor);
+  free (h->old_buckets);
   free (h->buckets);
 }
 
@@ -162,13 +168,12 @@ hash_delete (struct hash *h, struct hash_elem *e)
 void
 hash_apply (struct hash *h, hash_action_func *action) 
 {
-  size_t i;
+  struct list *bucket;
   
   ASSERT (action != NULL);
 
-  for (i = 0; i < h->bucket_cnt; i++) 
+  for (bucket = h->buckets; bucket != NULL; bucket = next_bucket (h, bucket))
     {
-      struct list *bucket = &h->buckets[i];
       struct list_elem *elem, *next;
 
       for (elem = list_begin (bucket); elem != list_end (bucket); elem = next) 
@@ -223,7 +228,8 @@ hash_next (struct hash_iterator *i)
   i->elem = list_elem_to_hash_elem (list_next (&i->elem->list_elem));
   while (i->elem == list_elem_to_hash_elem (list_end (i->bucket)))
     {
-      if (++i->bucket >= i->hash->buckets + i->hash->bucket_cnt)
+      i->bucket = next_bucket (i->hash, i->bucket);
+      if (i->bucket == NULL)
         {
           i->elem = NULL;
           break;
@@ -301,12 +307,39 @@ hash_int (int i)
   return hash_bytes (&i, sizeof i);
 }
 
-/* Returns the bucket in H that E belongs in. */
+/* Returns the bucket in H that E belongs in.  While H is being
+   resized, that is E's old bucket if it has not been emptied yet,
+   and its new bucket otherwise. */
 static struct list *
 find_bucket (struct hash *h, struct hash_elem *e) 
 {
-  size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-  return &h->buckets[bucket_idx];
+  unsigned hash = h->hash (e, h->aux);
+
+  if (h->old_buckets != NULL) 
+    {
+      size_t old_idx = hash & (h->old_bucket_cnt - 1);
+      if (old_idx >= h->migrated)
+        return &h->old_buckets[old_idx];
+    }
+  return &h->buckets[hash & (h->bucket_cnt - 1)];
+}
+
+/* Returns the bucket that follows BUCKET when visiting every
+   bucket in H: first the current buckets, then the old buckets
+   that still hold elements, if H is being resized.  Returns a
+   null pointer after the last bucket. */
+static struct list *
+next_bucket (struct hash *h, struct list *bucket) 
+{
+  if (bucket >= h->buckets && bucket < h->buckets + h->bucket_cnt) 
+    {
+      if (++bucket < h->buckets + h->bucket_cnt)
+        return bucket;
+      if (h->old_buckets == NULL || h->migrated >= h->old_bucket_cnt)
+        return NULL;
+      return h->old_buckets + h->migrated;
+    }
+  return ++bucket < h->old_buckets + h->old_bucket_cnt ? bucket : NULL;
 }
 
 /* Searches BUCKET in H for a hash element equal to E.  Returns
@@ -344,22 +377,34 @@ is_power_of_2 (size_t x)
 #define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
 #define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
 
+/* Number of old buckets emptied per insertion or deletion while
+   a table is being resized. */
+#define MIGRATE_BUCKETS 4
+
 /* Changes the number of buckets in hash table H to match the
    ideal.  This function can fail because of an out-of-memory
    condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+   we can still continue.
+
+   The elements are not moved here, except for those in the first
+   few old buckets.  Instead, each later call moves a few more,
+   until the old buckets are empty and can be freed.  Only then
+   do we consider changing the number of buckets again. */
 static void
 rehash (struct hash *h) 
 {
-  size_t old_bucket_cnt, new_bucket_cnt;
-  struct list *new_buckets, *old_buckets;
+  size_t new_bucket_cnt;
+  struct list *new_buckets;
   size_t i;
 
   ASSERT (h != NULL);
 
-  /* Save old bucket info for later use. */
-  old_buckets = h->buckets;
-  old_bucket_cnt = h->bucket_cnt;
+  /* Finish one resize before starting another. */
+  if (h->old_buckets != NULL)
+    {
+      migrate (h);
+      return;
+    }
 
   /* Calculate the number of buckets to use now.
      We want one bucket for about every BEST_ELEMS_PER_BUCKET.
@@ -372,7 +417,7 @@ rehash (struct hash *h)
     new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
 
   /* Don't do anything if the bucket count wouldn't change. */
-  if (new_bucket_cnt == old_bucket_cnt)
+  if (new_bucket_cnt == h->bucket_cnt)
     return;
 
   /* Allocate new buckets and initialize them as empty. */
@@ -387,29 +432,41 @@ rehash (struct hash *h)
   for (i = 0; i < new_bucket_cnt; i++) 
     list_init (&new_buckets[i]);
 
-  /* Install new bucket info. */
+  /* Install new bucket info, keeping the old buckets until they
+     have been emptied. */
+  h->old_buckets = h->buckets;
+  h->old_bucket_cnt = h->bucket_cnt;
+  h->migrated = 0;
   h->buckets = new_buckets;
   h->bucket_cnt = new_bucket_cnt;
+  migrate (h);
+}
 
-  /* Move each old element into the appropriate new bucket. */
-  for (i = 0; i < old_bucket_cnt; i++) 
+/* Moves the elements in the next MIGRATE_BUCKETS old buckets of
+   H, which must be being resized, into the new buckets.  Frees
+   the old buckets once they are all empty. */
+static void
+migrate (struct hash *h) 
+{
+  size_t i;
+
+  for (i = 0; i < MIGRATE_BUCKETS && h->migrated < h->old_bucket_cnt; i++)
     {
-      struct list *old_bucket;
-      struct list_elem *elem, *next;
+      struct list *old_bucket = &h->old_buckets[h->migrated++];
 
-      old_bucket = &old_buckets[i];
-      for (elem = list_begin (old_bucket);
-           elem != list_end (old_bucket); elem = next) 
+      while (!list_empty (old_bucket)) 
         {
-          struct list *new_bucket
-            = find_bucket (h, list_elem_to_hash_elem (elem));
-          next = list_next (elem);
-          list_remove (elem);
-          list_push_front (new_bucket, elem);
+          struct list_elem *elem = list_pop_front (old_bucket);
+          list_push_front (find_bucket (h, list_elem_to_hash_elem (elem)),
+                           elem);
         }
     }
 
-  free (old_buckets);
+  if (h->migrated >= h->old_bucket_cnt) 
+    {
+      free (h->old_buckets);
+      h->old_buckets = NULL;
+    }
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -428,3 +485,283 @@ remove_elem (struct hash *h, struct hash_elem *e)
   list_remove (&e->list_elem);
 }
 
+
+/* Open-addressing hash table.
+
+   Slots are probed linearly from the one selected by the low bits
+   of the hash value.  Each slot caches its element's hash value,
+   so probing past other elements only compares integers and calls
+   the comparison function only on a likely match.  Deletion
+   shifts later elements of the probe run back instead of leaving
+   tombstones, so probe runs never get longer than the elements in
+   them require.  The table keeps between 1/8 and 3/4 of its slots
+   full, resizing by a factor of 2, with at least OHASH_MIN_SLOTS
+   slots.  Resizing copies slots without calling the hash function
+   again. */
+
+#define OHASH_MIN_SLOTS 8
+
+static bool ohash_resize (struct ohash *, size_t slot_cnt);
+static size_t ohash_find_slot (struct ohash *, struct ohash_elem *,
+                               unsigned hash);
+static void ohash_remove_slot (struct ohash *, size_t slot);
+
+/* Initializes open-addressing hash table H to compute hash values
+   using HASH and compare elements using LESS, given auxiliary data
+   AUX. */
+bool
+ohash_init (struct ohash *h,
+            ohash_hash_func *hash, ohash_less_func *less, void *aux) 
+{
+  h->elem_cnt = 0;
+  h->slot_cnt = OHASH_MIN_SLOTS;
+  h->slots = calloc (h->slot_cnt, sizeof *h->slots);
+  h->hash = hash;
+  h->less = less;
+  h->aux = aux;
+  return h->slots != NULL;
+}
+
+/* Removes all the elements from H, calling DESTRUCTOR for each
+   one if it is non-null, as in hash_clear(). */
+void
+ohash_clear (struct ohash *h, ohash_action_func *destructor) 
+{
+  size_t i;
+
+  for (i = 0; i < h->slot_cnt; i++) 
+    {
+      struct ohash_elem *e = h->slots[i].elem;
+      h->slots[i].elem = NULL;
+      if (e != NULL && destructor != NULL)
+        destructor (e, h->aux);
+    }
+  h->elem_cnt = 0;
+}
+
+/* Destroys H, first calling DESTRUCTOR for each element if it is
+   non-null, as in hash_destroy(). */
+void
+ohash_destroy (struct ohash *h, ohash_action_func *destructor) 
+{
+  if (destructor != NULL)
+    ohash_clear (h, destructor);
+  free (h->slots);
+}
+
+/* Inserts NEW into H and returns a null pointer, if no equal
+   element is already in the table.  If an equal element is
+   already in the table, returns it without inserting NEW.  If
+   the table is full and cannot grow, NEW is not inserted and
+   NEW itself is returned. */
+struct ohash_elem *
+ohash_insert (struct ohash *h, struct ohash_elem *new) 
+{
+  unsigned hash = h->hash (new, h->aux);
+  size_t slot = ohash_find_slot (h, new, hash);
+
+  if (h->slots[slot].elem != NULL)
+    return h->slots[slot].elem;
+
+  /* Grow at 3/4 full.  The slot we found moves if we do. */
+  if ((h->elem_cnt + 1) * 4 > h->slot_cnt * 3) 
+    {
+      if (!ohash_resize (h, h->slot_cnt * 2)
+          && h->elem_cnt + 1 >= h->slot_cnt)
+        return new;
+      slot = ohash_find_slot (h, new, hash);
+    }
+
+  new->hash = hash;
+  h->slots[slot].hash = hash;
+  h->slots[slot].elem = new;
+  h->elem_cnt++;
+  return NULL;
+}
+
+/* Inserts NEW into H, replacing any equal element already in the
+   table, which is returned. */
+struct ohash_elem *
+ohash_replace (struct ohash *h, struct ohash_elem *new) 
+{
+  unsigned hash = h->hash (new, h->aux);
+  size_t slot = ohash_find_slot (h, new, hash);
+  struct ohash_elem *old = h->slots[slot].elem;
+
+  if (old == NULL)
+    return ohash_insert (h, new);
+
+  new->hash = hash;
+  h->slots[slot].elem = new;
+  return old;
+}
+
+/* Finds and returns an element equal to E in H, or a null
+   pointer if no equal element exists in the table. */
+struct ohash_elem *
+ohash_find (struct ohash *h, struct ohash_elem *e) 
+{
+  return h->slots[ohash_find_slot (h, e, h->hash (e, h->aux))].elem;
+}
+
+/* Finds, removes, and returns an element equal to E in H.
+   Returns a null pointer if no equal element existed in the
+   table. */
+struct ohash_elem *
+ohash_delete (struct ohash *h, struct ohash_elem *e) 
+{
+  size_t slot = ohash_find_slot (h, e, h->hash (e, h->aux));
+  struct ohash_elem *found = h->slots[slot].elem;
+
+  if (found != NULL) 
+    {
+      ohash_remove_slot (h, slot);
+      h->elem_cnt--;
+
+      /* Shrink at 1/8 full.  Failure just wastes some space. */
+      if (h->slot_cnt > OHASH_MIN_SLOTS && h->elem_cnt * 8 < h->slot_cnt)
+        ohash_resize (h, h->slot_cnt / 2);
+    }
+  return found;
+}
+
+/* Calls ACTION for each element in H in arbitrary order.  H must
+   not be modified meanwhile. */
+void
+ohash_apply (struct ohash *h, ohash_action_func *action) 
+{
+  size_t i;
+
+  ASSERT (action != NULL);
+
+  for (i = 0; i < h->slot_cnt; i++)
+    if (h->slots[i].elem != NULL)
+      action (h->slots[i].elem, h->aux);
+}
+
+/* Initializes I for iterating H, with the same idiom as
+   hash_first().  Modifying H invalidates all iterators. */
+void
+ohash_first (struct ohash_iterator *i, struct ohash *h) 
+{
+  ASSERT (i != NULL);
+  ASSERT (h != NULL);
+
+  i->hash = h;
+  i->slot = (size_t) -1;
+}
+
+/* Advances I to the next element in the table and returns it.
+   Returns a null pointer if no elements are left. */
+struct ohash_elem *
+ohash_next (struct ohash_iterator *i) 
+{
+  ASSERT (i != NULL);
+
+  while (++i->slot < i->hash->slot_cnt)
+    if (i->hash->slots[i->slot].elem != NULL)
+      return i->hash->slots[i->slot].elem;
+  i->slot = i->hash->slot_cnt;
+  return NULL;
+}
+
+/* Returns the current element in the iteration, or a null
+   pointer at the end of the table.  Undefined behavior after
+   calling ohash_first() but before ohash_next(). */
+struct ohash_elem *
+ohash_cur (struct ohash_iterator *i) 
+{
+  return i->slot < i->hash->slot_cnt ? i->hash->slots[i->slot].elem : NULL;
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) 
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) 
+{
+  return h->elem_cnt == 0;
+}
+
+/* Returns the slot in H that holds an element equal to E, whose
+   hash value is HASH, or the empty slot where it would go if
+   there is none. */
+static size_t
+ohash_find_slot (struct ohash *h, struct ohash_elem *e, unsigned hash) 
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t slot;
+
+  for (slot = hash & mask; h->slots[slot].elem != NULL;
+       slot = (slot + 1) & mask) 
+    {
+      struct ohash_slot *s = &h->slots[slot];
+      if (s->hash == hash
+          && !h->less (s->elem, e, h->aux) && !h->less (e, s->elem, h->aux))
+        break;
+    }
+  return slot;
+}
+
+/* Empties SLOT in H, moving back any later elements in the same
+   probe run that could no longer be found past the gap. */
+static void
+ohash_remove_slot (struct ohash *h, size_t slot) 
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t next;
+
+  for (next = (slot + 1) & mask; h->slots[next].elem != NULL;
+       next = (next + 1) & mask) 
+    {
+      /* Distance of NEXT's element from its home slot, and of the
+         gap from the same home slot.  The element can move into
+         the gap only if the gap is no farther from home. */
+      size_t home = h->slots[next].hash & mask;
+      if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+          h->slots[slot] = h->slots[next];
+          slot = next;
+        }
+    }
+  h->slots[slot].elem = NULL;
+}
+
+/* Changes the number of slots in H to SLOT_CNT, a power of 2
+   large enough for all of H's elements.  Returns false if out of
+   memory, in which case H is unchanged. */
+static bool
+ohash_resize (struct ohash *h, size_t slot_cnt) 
+{
+  struct ohash_slot *old_slots = h->slots;
+  size_t old_slot_cnt = h->slot_cnt;
+  size_t mask = slot_cnt - 1;
+  size_t i;
+
+  ASSERT (is_power_of_2 (slot_cnt) && slot_cnt > h->elem_cnt);
+
+  h->slots = calloc (slot_cnt, sizeof *h->slots);
+  if (h->slots == NULL) 
+    {
+      h->slots = old_slots;
+      return false;
+    }
+  h->slot_cnt = slot_cnt;
+
+  for (i = 0; i < old_slot_cnt; i++)
+    if (old_slots[i].elem != NULL) 
+      {
+        size_t slot = old_slots[i].hash & mask;
+        while (h->slots[slot].elem != NULL)
+          slot = (slot + 1) & mask;
+        h->slots[slot] = old_slots[i];
+      }
+
+  free (old_slots);
+  return true;
+}
@@ -18,7 +18,21 @@
    conversion from a struct hash_elem back to a structure object
    that contains it.  This is the same technique used in the
    linked list implementation.  Refer to lib/kernel/list.h for a
-   detailed explanation. */
+   detailed explanation.
+
+   The table grows and shrinks incrementally: when the number of
+   buckets needs to change, a new bucket array is allocated, and
+   each later insertion or deletion moves the elements of a few
+   old buckets into it, so that no single operation has to touch
+   every element.
+
+   This file also declares "struct ohash", an open-addressing
+   variant with the same interface (with an "ohash_" prefix).  It
+   keeps pointers to elements, along with their hash values, in
+   one flat array probed linearly, so a lookup usually touches a
+   single cache line instead of following a list per bucket.  It
+   suits tables that are searched much more often than they
+   change. */
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -61,6 +75,10 @@ struct hash
     size_t elem_cnt;            /* Number of elements in table. */
     size_t bucket_cnt;          /* Number of buckets, a power of 2. */
     struct list *buckets;       /* Array of `bucket_cnt' lists. */
+    struct list *old_buckets;   /* While resizing, buckets being emptied
+                                   into `buckets'; otherwise null. */
+    size_t old_bucket_cnt;      /* Number of old buckets. */
+    size_t migrated;            /* Number of old buckets emptied. */
     hash_hash_func *hash;       /* Hash function. */
     hash_less_func *less;       /* Comparison function. */
     void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -95,6 +113,79 @@ struct hash_elem *hash_cur (struct hash_iterator *);
 size_t hash_size (struct hash *);
 bool hash_empty (struct hash *);
 
+/* Open-addressing hash element. */
+struct ohash_elem 
+  {
+    unsigned hash;              /* Hash value, set by the table. */
+  };
+
+/* Converts pointer to open-addressing hash element OHASH_ELEM
+   into a pointer to the structure that OHASH_ELEM is embedded
+   inside, like hash_entry(). */
+#define ohash_entry(OHASH_ELEM, STRUCT, MEMBER)                 \
+        ((STRUCT *) ((uint8_t *) (OHASH_ELEM)                   \
+                     - offsetof (STRUCT, MEMBER)))
+
+/* Computes and returns the hash value for element E, given
+   auxiliary data AUX. */
+typedef unsigned ohash_hash_func (const struct ohash_elem *e, void *aux);
+
+/* Returns true if A is less than B, given auxiliary data AUX. */
+typedef bool ohash_less_func (const struct ohash_elem *a,
+                              const struct ohash_elem *b,
+                              void *aux);
+
+/* Performs some operation on element E, given auxiliary data
+   AUX. */
+typedef void ohash_action_func (struct ohash_elem *e, void *aux);
+
+/* A slot in an open-addressing hash table. */
+struct ohash_slot 
+  {
+    unsigned hash;              /* Hash value of ELEM. */
+    struct ohash_elem *elem;    /* Element, or null if empty. */
+  };
+
+/* Open-addressing hash table. */
+struct ohash 
+  {
+    size_t elem_cnt;            /* Number of elements in table. */
+    size_t slot_cnt;            /* Number of slots, a power of 2. */
+    struct ohash_slot *slots;   /* Array of `slot_cnt' slots. */
+    ohash_hash_func *hash;      /* Hash function. */
+    ohash_less_func *less;      /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `hash' and `less'. */
+  };
+
+/* An open-addressing hash table iterator. */
+struct ohash_iterator 
+  {
+    struct ohash *hash;         /* The hash table. */
+    size_t slot;                /* Current slot. */
+  };
+
+/* Basic life cycle. */
+bool ohash_init (struct ohash *, ohash_hash_func *, ohash_less_func *,
+                 void *aux);
+void ohash_clear (struct ohash *, ohash_action_func *);
+void ohash_destroy (struct ohash *, ohash_action_func *);
+
+/* Search, insertion, deletion. */
+struct ohash_elem *ohash_insert (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_replace (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_find (struct ohash *, struct ohash_elem *);
+struct ohash_elem *ohash_delete (struct ohash *, struct ohash_elem *);
+
+/* Iteration. */
+void ohash_apply (struct ohash *, ohash_action_func *);
+void ohash_first (struct ohash_iterator *, struct ohash *);
+struct ohash_elem *ohash_next (struct ohash_iterator *);
+struct ohash_elem *ohash_cur (struct ohash_iterator *);
+
+/* Information. */
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
 /* Sample hash functions. */
 unsigned hash_bytes (const void *, size_t);
 unsigned hash_string (const char *);
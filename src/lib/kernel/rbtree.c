@@ -0,0 +1,474 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.  The algorithms follow
+   [CLRS] chapter 13, with null pointers in place of the sentinel
+   leaf, so the removal fix-up tracks the parent of the node it
+   is working on separately. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static void rotate_left (struct rbtree *, struct rb_elem *);
+static void rotate_right (struct rbtree *, struct rb_elem *);
+static void replace_child (struct rbtree *, struct rb_elem *parent,
+                           struct rb_elem *old, struct rb_elem *new);
+static void insert_fixup (struct rbtree *, struct rb_elem *);
+static void remove_fixup (struct rbtree *, struct rb_elem *,
+                          struct rb_elem *parent);
+static struct rb_elem *first_leaf (struct rb_elem *);
+
+/* Returns true if E is a red node.  Null leaves are black. */
+static inline bool
+is_red (const struct rb_elem *e)
+{
+  return e != NULL && e->red;
+}
+
+/* Initializes tree T to be empty, ordered by LESS given
+   auxiliary data AUX. */
+void
+rb_init (struct rbtree *t, rb_less_func *less, void *aux)
+{
+  ASSERT (t != NULL);
+  ASSERT (less != NULL);
+
+  t->root = NULL;
+  t->elem_cnt = 0;
+  t->less = less;
+  t->aux = aux;
+}
+
+/* Removes all the elements from T.
+
+   If DESTRUCTOR is non-null, then it is called for each element
+   in the tree, children before parents.  DESTRUCTOR may, if
+   appropriate, deallocate the memory used by the element.
+   However, modifying tree T while rb_clear() is running, using
+   any of the functions rb_clear(), rb_insert(), or rb_remove(),
+   yields undefined behavior, whether done in DESTRUCTOR or
+   elsewhere. */
+void
+rb_clear (struct rbtree *t, rb_action_func *destructor)
+{
+  struct rb_elem *e = t->root != NULL ? first_leaf (t->root) : NULL;
+
+  /* Detach each leaf from its parent before destroying it, so
+     that its parent becomes a leaf in turn. */
+  while (e != NULL)
+    {
+      struct rb_elem *parent = e->parent;
+
+      if (parent != NULL)
+        {
+          if (parent->left == e)
+            parent->left = NULL;
+          else
+            parent->right = NULL;
+        }
+      if (destructor != NULL)
+        destructor (e, t->aux);
+      e = parent != NULL ? first_leaf (parent) : NULL;
+    }
+
+  t->root = NULL;
+  t->elem_cnt = 0;
+}
+
+/* Inserts NEW into tree T and returns a null pointer, if no
+   equal element is already in the tree.
+   If an equal element is already in the tree, returns it
+   without inserting NEW. */
+struct rb_elem *
+rb_insert (struct rbtree *t, struct rb_elem *new)
+{
+  struct rb_elem *parent = NULL;
+  struct rb_elem **link = &t->root;
+
+  while (*link != NULL)
+    {
+      parent = *link;
+      if (t->less (new, parent, t->aux))
+        link = &parent->left;
+      else if (t->less (parent, new, t->aux))
+        link = &parent->right;
+      else
+        return parent;
+    }
+
+  new->parent = parent;
+  new->left = new->right = NULL;
+  new->red = true;
+  *link = new;
+  t->elem_cnt++;
+
+  insert_fixup (t, new);
+  return NULL;
+}
+
+/* Finds and returns an element equal to E in tree T, or a null
+   pointer if no equal element exists in the tree. */
+struct rb_elem *
+rb_find (struct rbtree *t, const struct rb_elem *e)
+{
+  struct rb_elem *found = rb_lower_bound (t, e);
+
+  return found != NULL && !t->less (e, found, t->aux) ? found : NULL;
+}
+
+/* Removes E, which must be in tree T, from the tree. */
+void
+rb_remove (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT (t->elem_cnt > 0);
+
+  if (e->left != NULL && e->right != NULL)
+    {
+      /* Replace E by its successor S, which has no left child,
+         and rebalance from where S used to be. */
+      struct rb_elem *s = e->right;
+      while (s->left != NULL)
+        s = s->left;
+
+      child = s->right;
+      parent = s->parent;
+      removed_red = s->red;
+      if (parent == e)
+        parent = s;
+      else
+        {
+          if (child != NULL)
+            child->parent = parent;
+          parent->left = child;
+          s->right = e->right;
+          e->right->parent = s;
+        }
+
+      s->left = e->left;
+      e->left->parent = s;
+      s->parent = e->parent;
+      replace_child (t, e->parent, e, s);
+      s->red = e->red;
+    }
+  else
+    {
+      child = e->left != NULL ? e->left : e->right;
+      parent = e->parent;
+      removed_red = e->red;
+      if (child != NULL)
+        child->parent = parent;
+      replace_child (t, parent, e, child);
+    }
+  t->elem_cnt--;
+
+  if (!removed_red)
+    remove_fixup (t, child, parent);
+}
+
+/* Returns the smallest element in T that is greater than or
+   equal to E, or a null pointer if there is none. */
+struct rb_elem *
+rb_lower_bound (struct rbtree *t, const struct rb_elem *e)
+{
+  struct rb_elem *node = t->root;
+  struct rb_elem *found = NULL;
+
+  while (node != NULL)
+    if (t->less (node, e, t->aux))
+      node = node->right;
+    else
+      {
+        found = node;
+        node = node->left;
+      }
+  return found;
+}
+
+/* Returns the smallest element in T that is greater than E, or
+   a null pointer if there is none. */
+struct rb_elem *
+rb_upper_bound (struct rbtree *t, const struct rb_elem *e)
+{
+  struct rb_elem *node = t->root;
+  struct rb_elem *found = NULL;
+
+  while (node != NULL)
+    if (t->less (e, node, t->aux))
+      {
+        found = node;
+        node = node->left;
+      }
+    else
+      node = node->right;
+  return found;
+}
+
+/* Returns the smallest element in T, or a null pointer if T is
+   empty. */
+struct rb_elem *
+rb_min (struct rbtree *t)
+{
+  struct rb_elem *e = t->root;
+
+  if (e != NULL)
+    while (e->left != NULL)
+      e = e->left;
+  return e;
+}
+
+/* Returns the largest element in T, or a null pointer if T is
+   empty. */
+struct rb_elem *
+rb_max (struct rbtree *t)
+{
+  struct rb_elem *e = t->root;
+
+  if (e != NULL)
+    while (e->right != NULL)
+      e = e->right;
+  return e;
+}
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the largest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->right != NULL)
+    {
+      e = e->right;
+      while (e->left != NULL)
+        e = e->left;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the element that precedes E in its tree, or a null
+   pointer if E is the smallest element. */
+struct rb_elem *
+rb_prev (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->left != NULL)
+    {
+      e = e->left;
+      while (e->right != NULL)
+        e = e->right;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->left)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rb_size (struct rbtree *t)
+{
+  return t->elem_cnt;
+}
+
+/* Returns true if T contains no elements, false otherwise. */
+bool
+rb_empty (struct rbtree *t)
+{
+  return t->elem_cnt == 0;
+}
+
+/* Makes OLD's right child take OLD's place in T, with OLD as
+   its left child. */
+static void
+rotate_left (struct rbtree *t, struct rb_elem *old)
+{
+  struct rb_elem *new = old->right;
+
+  old->right = new->left;
+  if (new->left != NULL)
+    new->left->parent = old;
+  new->parent = old->parent;
+  replace_child (t, old->parent, old, new);
+  new->left = old;
+  old->parent = new;
+}
+
+/* Makes OLD's left child take OLD's place in T, with OLD as its
+   right child. */
+static void
+rotate_right (struct rbtree *t, struct rb_elem *old)
+{
+  struct rb_elem *new = old->left;
+
+  old->left = new->right;
+  if (new->right != NULL)
+    new->right->parent = old;
+  new->parent = old->parent;
+  replace_child (t, old->parent, old, new);
+  new->right = old;
+  old->parent = new;
+}
+
+/* Makes NEW the child of PARENT in place of OLD, or the root of
+   T if PARENT is null.  Does not update NEW's parent pointer. */
+static void
+replace_child (struct rbtree *t, struct rb_elem *parent,
+               struct rb_elem *old, struct rb_elem *new)
+{
+  if (parent == NULL)
+    t->root = new;
+  else if (parent->left == old)
+    parent->left = new;
+  else
+    parent->right = new;
+}
+
+/* Restores the red-black properties of T after red node E was
+   inserted as a leaf. */
+static void
+insert_fixup (struct rbtree *t, struct rb_elem *e)
+{
+  struct rb_elem *parent;
+
+  while ((parent = e->parent) != NULL && parent->red)
+    {
+      /* A red node is never the root, so GRANDPARENT exists. */
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left)
+        {
+          struct rb_elem *uncle = grandparent->right;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->right)
+            {
+              rotate_left (t, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_right (t, grandparent);
+        }
+      else
+        {
+          struct rb_elem *uncle = grandparent->left;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->left)
+            {
+              rotate_right (t, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_left (t, grandparent);
+        }
+    }
+  t->root->red = false;
+}
+
+/* Restores the red-black properties of T after a black node was
+   removed, leaving E, which may be null, one black node short.
+   PARENT is E's parent. */
+static void
+remove_fixup (struct rbtree *t, struct rb_elem *e, struct rb_elem *parent)
+{
+  while (e != t->root && !is_red (e))
+    {
+      /* E is short a black node, so its sibling can't be a null
+         leaf. */
+      if (e == parent->left)
+        {
+          struct rb_elem *sibling = parent->right;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_left (t, parent);
+              sibling = parent->right;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+              continue;
+            }
+          if (!is_red (sibling->right))
+            {
+              sibling->left->red = false;
+              sibling->red = true;
+              rotate_right (t, sibling);
+              sibling = parent->right;
+            }
+          sibling->red = parent->red;
+          parent->red = false;
+          sibling->right->red = false;
+          rotate_left (t, parent);
+        }
+      else
+        {
+          struct rb_elem *sibling = parent->left;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_right (t, parent);
+              sibling = parent->left;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+              continue;
+            }
+          if (!is_red (sibling->left))
+            {
+              sibling->right->red = false;
+              sibling->red = true;
+              rotate_left (t, sibling);
+              sibling = parent->left;
+            }
+          sibling->red = parent->red;
+          parent->red = false;
+          sibling->left->red = false;
+          rotate_right (t, parent);
+        }
+      e = t->root;
+    }
+  if (e != NULL)
+    e->red = false;
+}
+
+/* Returns the first node without children reached from E by
+   preferring left children over right ones. */
+static struct rb_elem *
+first_leaf (struct rb_elem *e)
+{
+  for (;;)
+    if (e->left != NULL)
+      e = e->left;
+    else if (e->right != NULL)
+      e = e->right;
+    else
+      return e;
+}
@@ -0,0 +1,106 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+
+   An ordered map that keeps its elements sorted by a caller
+   supplied comparison function, with O(log n) insertion,
+   deletion, and search.  Unlike a sorted list, it can also find
+   the first element at or after a given key in O(log n), which
+   makes range queries (for example, "which mapping overlaps this
+   address range?") cheap.
+
+   Like lists and hash tables, the tree is intrusive: it does not
+   allocate memory.  Each structure that can be in a tree embeds
+   a struct rb_elem member, and the rb_entry macro converts a
+   struct rb_elem back into the structure that contains it.
+   Refer to lib/kernel/list.h for a detailed explanation of the
+   technique.
+
+   A tree holds at most one element for each key: rb_insert()
+   refuses an element that compares equal to one already present.
+   A caller that needs duplicate keys, such as a queue of threads
+   ordered by wake-up time, can break ties by comparing some
+   other unique member, such as the element's address.
+
+   Iteration is in order, with rb_min() and rb_next() going from
+   smallest to largest and rb_max() and rb_prev() going the other
+   way; all of them return a null pointer past the end.  For
+   example:
+
+      struct rb_elem *e;
+
+      for (e = rb_min (&tree); e != NULL; e = rb_next (e))
+        {
+          struct foo *f = rb_entry (e, struct foo, elem);
+          ...do something with f...
+        }
+
+   Inserting or removing elements invalidates only iterators that
+   point to the removed element. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Red-black tree element. */
+struct rb_elem
+  {
+    struct rb_elem *parent;     /* Parent, or null at the root. */
+    struct rb_elem *left;       /* Smaller elements. */
+    struct rb_elem *right;      /* Larger elements. */
+    bool red;                   /* Node color. */
+  };
+
+/* Converts pointer to tree element RB_ELEM into a pointer to the
+   structure that RB_ELEM is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)                       \
+        ((STRUCT *) ((uint8_t *) &(RB_ELEM)->parent             \
+                     - offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+                           const struct rb_elem *b,
+                           void *aux);
+
+/* Performs some operation on tree element E, given auxiliary
+   data AUX. */
+typedef void rb_action_func (struct rb_elem *e, void *aux);
+
+/* Red-black tree. */
+struct rbtree
+  {
+    struct rb_elem *root;       /* Root element, or null if empty. */
+    size_t elem_cnt;            /* Number of elements in tree. */
+    rb_less_func *less;         /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+/* Basic life cycle. */
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+void rb_clear (struct rbtree *, rb_action_func *);
+
+/* Search, insertion, deletion. */
+struct rb_elem *rb_insert (struct rbtree *, struct rb_elem *);
+struct rb_elem *rb_find (struct rbtree *, const struct rb_elem *);
+void rb_remove (struct rbtree *, struct rb_elem *);
+
+/* Range queries. */
+struct rb_elem *rb_lower_bound (struct rbtree *, const struct rb_elem *);
+struct rb_elem *rb_upper_bound (struct rbtree *, const struct rb_elem *);
+
+/* Iteration. */
+struct rb_elem *rb_min (struct rbtree *);
+struct rb_elem *rb_max (struct rbtree *);
+struct rb_elem *rb_next (struct rb_elem *);
+struct rb_elem *rb_prev (struct rb_elem *);
+
+/* Information. */
+size_t rb_size (struct rbtree *);
+bool rb_empty (struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
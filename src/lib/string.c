@@ -1,5 +1,84 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* The block functions below work a 32-bit word at a time
+   wherever they can.  Copies and fills use the x86 string
+   instructions, which move a word per iteration once the
+   destination is word-aligned: a few single bytes up to the
+   first word boundary, then "rep movsl" or "rep stosl" for the
+   bulk, then the last few bytes.  Short blocks aren't worth the
+   setup and go byte by byte.
+
+   Both the kernel and user programs enter these functions with
+   the direction flag clear, as the i386 ABI requires, and the
+   kernel clears it on every interrupt entry. */
+
+/* Blocks shorter than this are handled a byte at a time. */
+#define WORD_THRESHOLD 16
+
+/* A word that may alias any other type, so that byte buffers can
+   be read a word at a time. */
+typedef uint32_t __attribute__ ((may_alias)) word_t;
+
+/* Number of bytes from P up to the next word boundary. */
+static inline size_t
+bytes_to_align (const void *p) 
+{
+  return -(uintptr_t) p & (sizeof (word_t) - 1);
+}
+
+/* Copies SIZE bytes forward from SRC to DST. */
+static inline void
+copy_forward (unsigned char *dst, const unsigned char *src, size_t size) 
+{
+  if (size >= WORD_THRESHOLD) 
+    {
+      size_t head = bytes_to_align (dst);
+      size_t words = (size - head) / sizeof (word_t);
+      size = (size - head) % sizeof (word_t);
+      asm volatile ("rep movsb"
+                    : "+D" (dst), "+S" (src), "+c" (head) : : "memory");
+      asm volatile ("rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+    }
+  asm volatile ("rep movsb"
+                : "+D" (dst), "+S" (src), "+c" (size) : : "memory");
+}
+
+/* Copies SIZE bytes backward from SRC to DST, starting with the
+   last byte, so that overlapping blocks with DST above SRC come
+   out right. */
+static inline void
+copy_backward (unsigned char *dst, const unsigned char *src, size_t size) 
+{
+  /* Point at the last byte of each block. */
+  dst += size - 1;
+  src += size - 1;
+
+  asm volatile ("std");
+  if (size >= WORD_THRESHOLD) 
+    {
+      /* Bytes above the last word boundary in DST. */
+      size_t tail = (uintptr_t) (dst + 1) & (sizeof (word_t) - 1);
+      size_t words = (size - tail) / sizeof (word_t);
+      size = (size - tail) % sizeof (word_t);
+      asm volatile ("rep movsb"
+                    : "+D" (dst), "+S" (src), "+c" (tail) : : "memory");
+
+      /* "rep movsl" going down takes the address of the lowest
+         byte of the word. */
+      dst -= sizeof (word_t) - 1;
+      src -= sizeof (word_t) - 1;
+      asm volatile ("rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+      dst += sizeof (word_t) - 1;
+      src += sizeof (word_t) - 1;
+    }
+  asm volatile ("rep movsb"
+                : "+D" (dst), "+S" (src), "+c" (size) : : "memory");
+  asm volatile ("cld");
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,9 +91,7 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
-
+  copy_forward (dst, src, size);
   return dst_;
 }
 
@@ -29,20 +106,12 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
-  else 
-    {
-      dst += size;
-      src += size;
-      while (size-- > 0)
-        *--dst = *--src;
-    }
+  if (dst <= src || dst >= src + size)
+    copy_forward (dst, src, size);
+  else if (size > 0)
+    copy_backward (dst, src, size);
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +127,20 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words.  x86 allows unaligned loads, so only
+     A needs to be aligned to keep most loads on word
+     boundaries. */
+  if (size >= WORD_THRESHOLD) 
+    {
+      for (; bytes_to_align (a) != 0; a++, b++, size--)
+        if (*a != *b)
+          return *a > *b ? +1 : -1;
+      for (; size >= sizeof (word_t);
+           a += sizeof (word_t), b += sizeof (word_t), size -= sizeof (word_t))
+        if (*(const word_t *) a != *(const word_t *) b)
+          break;
+    }
+
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -281,9 +364,20 @@ memset (void *dst_, int value, size_t size)
   unsigned char *dst = dst_;
 
   ASSERT (dst != NULL || size == 0);
-  
-  while (size-- > 0)
-    *dst++ = value;
+
+  if (size >= WORD_THRESHOLD) 
+    {
+      size_t head = bytes_to_align (dst);
+      size_t words = (size - head) / sizeof (word_t);
+      word_t word = (unsigned char) value * 0x01010101u;
+      size = (size - head) % sizeof (word_t);
+      asm volatile ("rep stosb"
+                    : "+D" (dst), "+c" (head) : "a" (value) : "memory");
+      asm volatile ("rep stosl"
+                    : "+D" (dst), "+c" (words) : "a" (word) : "memory");
+    }
+  asm volatile ("rep stosb"
+                : "+D" (dst), "+c" (size) : "a" (value) : "memory");
 
   return dst_;
 }
@@ -296,8 +390,22 @@ strlen (const char *string)
 
   ASSERT (string != NULL);
 
-  for (p = string; *p != '\0'; p++)
-    continue;
+  /* Check bytes up to a word boundary, then whole words for a
+     zero byte.  An aligned word never straddles a page boundary,
+     so reading past the end of STRING within the last word is
+     safe. */
+  for (p = string; bytes_to_align (p) != 0; p++)
+    if (*p == '\0')
+      return p - string;
+  for (;;) 
+    {
+      word_t w = *(const word_t *) p;
+      if (((w - 0x01010101u) & ~w & 0x80808080u) != 0)
+        break;
+      p += sizeof (word_t);
+    }
+  while (*p != '\0')
+    p++;
   return p - string;
 }
 
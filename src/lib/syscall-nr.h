@@ -28,7 +28,17 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_PREAD,                  /* Read from a file at a given position. */
+    SYS_PWRITE,                 /* Write to a file at a given position. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write to a file from several buffers. */
+    SYS_RING_SETUP,             /* Map a system call ring. */
+    SYS_RING_ENTER,             /* Carry out requests queued in the ring. */
+    SYS_FORK,                   /* Duplicate the calling process. */
+    SYS_WAITANY                 /* Wait for any child process to die. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -15,6 +15,76 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* One buffer in a readv() or writev() request. */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    unsigned iov_len;           /* Buffer size in bytes. */
+  };
+
+/* Maximum number of buffers in a readv() or writev() request. */
+#define IOV_MAX 1024
+
+/* System call ring.
+
+   A program that makes many file system calls can queue them in
+   a ring shared with the kernel, then have the kernel carry out
+   a whole batch with a single ring_enter() call.  ring_setup()
+   maps the ring at a page-aligned address of the program's
+   choosing.
+
+   The program fills in the request at sq[sq_tail % RING_ENTRIES]
+   and increments sq_tail.  The kernel takes requests in order
+   from sq_head and, for each one, posts its result at
+   cq[cq_tail % RING_ENTRIES] and increments cq_tail.  The
+   program takes results from cq_head.  All four indexes run
+   freely; the kernel stops when the completion queue is full. */
+#define RING_ENTRIES 64
+
+/* Operations in a ring request.  Each corresponds to the system
+   call of the same name and returns the same result, or 0 for
+   seek and close. */
+enum ring_op
+  {
+    RING_OP_READ,               /* read (fd, addr, len). */
+    RING_OP_WRITE,              /* write (fd, addr, len). */
+    RING_OP_PREAD,              /* pread (fd, addr, len, offset). */
+    RING_OP_PWRITE,             /* pwrite (fd, addr, len, offset). */
+    RING_OP_SEEK,               /* seek (fd, offset). */
+    RING_OP_CREATE,             /* create (addr, len). */
+    RING_OP_OPEN,               /* open (addr). */
+    RING_OP_CLOSE               /* close (fd). */
+  };
+
+/* A request in the submission queue. */
+struct ring_sqe
+  {
+    int opcode;                 /* One of RING_OP_*. */
+    int fd;                     /* File descriptor. */
+    void *addr;                 /* Buffer or file name. */
+    unsigned len;               /* Buffer size, or initial file size. */
+    unsigned offset;            /* File position. */
+    unsigned user_data;         /* Copied into the completion. */
+  };
+
+/* A result in the completion queue. */
+struct ring_cqe
+  {
+    unsigned user_data;         /* From the request. */
+    int res;                    /* Return value of the operation. */
+  };
+
+/* The shared ring, which occupies one page. */
+struct sys_ring
+  {
+    unsigned sq_head;           /* Next request for the kernel. */
+    unsigned sq_tail;           /* Next free request slot. */
+    unsigned cq_head;           /* Next result for the program. */
+    unsigned cq_tail;           /* Next free result slot. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -38,6 +108,29 @@ void close (int fd);
 mapid_t mmap (int fd, void *addr);
 void munmap (mapid_t);
 
+/* Positional and vectored I/O. */
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+
+/* System call ring. */
+int ring_setup (void *addr);
+int ring_enter (unsigned to_submit);
+
+/* Process duplication. */
+pid_t fork (void);
+
+/* Waits for whichever child process exits first, returning its
+   pid and storing its exit status in *STATUS if STATUS is
+   non-null, or returns -1 at once if the caller has no child
+   left to wait for. */
+pid_t waitany (int *status);
+
+/* Fast system call entry, set up by _start(). */
+extern bool syscall_sysenter;
+void syscall_init_fast (void);
+
 /* Project 4 only. */
 bool chdir (const char *dir);
 bool mkdir (const char *dir);
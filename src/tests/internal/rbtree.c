@@ -0,0 +1,212 @@
+/* Test program for lib/kernel/rbtree.c.
+
+   Inserts and removes values in random order, checking the
+   red-black invariants, in-order iteration, and range queries
+   after every step.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <rbtree.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Maximum number of elements in a tree that we will test. */
+#define MAX_SIZE 256
+
+/* A tree element.  Values are even, so that odd probes fall
+   between elements. */
+struct value
+  {
+    struct rb_elem elem;        /* Tree element. */
+    int value;                  /* Item value. */
+  };
+
+static void shuffle (int[], size_t);
+static bool value_less (const struct rb_elem *, const struct rb_elem *,
+                        void *);
+static void count_elem (struct rb_elem *, void *);
+static int verify_subtree (struct rb_elem *, struct rb_elem *parent);
+static void verify_tree (struct rbtree *, const bool present[], int size);
+
+/* Test the red-black tree implementation. */
+void
+test (void)
+{
+  int size;
+
+  printf ("testing various size trees:");
+  for (size = 0; size < MAX_SIZE; size = size * 4 / 3 + 1)
+    {
+      int repeat;
+
+      printf (" %d", size);
+      for (repeat = 0; repeat < 10; repeat++)
+        {
+          static struct value values[MAX_SIZE];
+          static int order[MAX_SIZE];
+          static bool present[MAX_SIZE];
+          struct value dup;
+          struct rbtree tree;
+          int i, cnt;
+
+          /* Insert values 0, 2, ..., 2 * (SIZE - 1) in random
+             order, verifying the tree after each insertion. */
+          for (i = 0; i < size; i++)
+            {
+              values[i].value = 2 * i;
+              order[i] = i;
+              present[i] = false;
+            }
+          shuffle (order, size);
+          rb_init (&tree, value_less, &cnt);
+          for (i = 0; i < size; i++)
+            {
+              ASSERT (rb_insert (&tree, &values[order[i]].elem) == NULL);
+              present[order[i]] = true;
+              verify_tree (&tree, present, size);
+            }
+
+          /* Inserting a duplicate must return the original. */
+          if (size > 0)
+            {
+              dup.value = values[order[0]].value;
+              ASSERT (rb_insert (&tree, &dup.elem) == &values[order[0]].elem);
+              ASSERT (rb_size (&tree) == (size_t) size);
+            }
+
+          /* Remove half of the values in random order. */
+          shuffle (order, size);
+          for (i = 0; i < size / 2; i++)
+            {
+              rb_remove (&tree, &values[order[i]].elem);
+              present[order[i]] = false;
+              verify_tree (&tree, present, size);
+            }
+
+          /* Clear the rest, counting the elements destroyed. */
+          cnt = 0;
+          rb_clear (&tree, count_elem);
+          ASSERT (cnt == size - size / 2);
+          ASSERT (rb_empty (&tree));
+          ASSERT (rb_min (&tree) == NULL);
+        }
+    }
+
+  printf (" done\n");
+  printf ("rbtree: PASS\n");
+}
+
+/* Shuffles the CNT elements in ARRAY into random order. */
+static void
+shuffle (int *array, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t j = i + random_ulong () % (cnt - i);
+      int t = array[j];
+      array[j] = array[i];
+      array[i] = t;
+    }
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+value_less (const struct rb_elem *a_, const struct rb_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = rb_entry (a_, struct value, elem);
+  const struct value *b = rb_entry (b_, struct value, elem);
+
+  return a->value < b->value;
+}
+
+/* Increments the counter that AUX points to. */
+static void
+count_elem (struct rb_elem *e UNUSED, void *aux)
+{
+  ++*(int *) aux;
+}
+
+/* Verifies the parent pointers and colors in the subtree rooted
+   at E, whose parent is PARENT, and returns its black height. */
+static int
+verify_subtree (struct rb_elem *e, struct rb_elem *parent)
+{
+  int left, right;
+
+  if (e == NULL)
+    return 1;
+  ASSERT (e->parent == parent);
+  ASSERT (!e->red
+          || ((e->left == NULL || !e->left->red)
+              && (e->right == NULL || !e->right->red)));
+  left = verify_subtree (e->left, e);
+  right = verify_subtree (e->right, e);
+  ASSERT (left == right);
+  return left + !e->red;
+}
+
+/* Verifies that TREE is a valid red-black tree holding exactly
+   the values 2 * I for which PRESENT[I] is true, 0 <= I < SIZE,
+   and that searches and range queries agree with PRESENT. */
+static void
+verify_tree (struct rbtree *tree, const bool present[], int size)
+{
+  struct rb_elem *e;
+  struct value probe;
+  int i, cnt;
+
+  ASSERT (tree->root == NULL || !tree->root->red);
+  verify_subtree (tree->root, NULL);
+
+  /* Forward and backward iteration. */
+  cnt = 0;
+  e = rb_min (tree);
+  for (i = 0; i < size; i++)
+    if (present[i])
+      {
+        ASSERT (rb_entry (e, struct value, elem)->value == 2 * i);
+        e = rb_next (e);
+        cnt++;
+      }
+  ASSERT (e == NULL);
+  ASSERT (rb_size (tree) == (size_t) cnt);
+  e = rb_max (tree);
+  for (i = size - 1; i >= 0; i--)
+    if (present[i])
+      {
+        ASSERT (rb_entry (e, struct value, elem)->value == 2 * i);
+        e = rb_prev (e);
+      }
+  ASSERT (e == NULL);
+
+  /* Exact and range queries on every value and between every
+     pair of values. */
+  for (i = 0; i < size; i++)
+    {
+      int j;
+
+      probe.value = 2 * i;
+      e = rb_find (tree, &probe.elem);
+      ASSERT (present[i]
+              ? rb_entry (e, struct value, elem)->value == 2 * i
+              : e == NULL);
+
+      probe.value = 2 * i - 1;
+      e = rb_lower_bound (tree, &probe.elem);
+      for (j = i; j < size && !present[j]; j++)
+        continue;
+      ASSERT (j < size
+              ? rb_entry (e, struct value, elem)->value == 2 * j
+              : e == NULL);
+      ASSERT (rb_upper_bound (tree, &probe.elem) == e);
+    }
+}
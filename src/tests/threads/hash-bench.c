@@ -0,0 +1,188 @@
+/* Compares the chained hash table, whose buckets are lists, with
+   the open-addressing variant, on insertions, successful and
+   unsuccessful lookups, and deletions.  Both tables are checked
+   for correctness as they go.
+
+   Timings are reported in timer ticks and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <hash.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+#define ELEM_CNT 4096           /* Elements in each table. */
+#define ROUND_CNT 10            /* Times to repeat each workload. */
+
+/* An element that can be in both kinds of table. */
+struct item
+  {
+    int key;
+    struct hash_elem hash_elem;
+    struct ohash_elem ohash_elem;
+  };
+
+static struct item items[ELEM_CNT];
+
+static unsigned
+item_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  return hash_int (hash_entry (e, struct item, hash_elem)->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED) 
+{
+  return (hash_entry (a, struct item, hash_elem)->key
+          < hash_entry (b, struct item, hash_elem)->key);
+}
+
+static unsigned
+item_ohash (const struct ohash_elem *e, void *aux UNUSED) 
+{
+  return hash_int (ohash_entry (e, struct item, ohash_elem)->key);
+}
+
+static bool
+item_oless (const struct ohash_elem *a, const struct ohash_elem *b,
+            void *aux UNUSED) 
+{
+  return (ohash_entry (a, struct item, ohash_elem)->key
+          < ohash_entry (b, struct item, ohash_elem)->key);
+}
+
+/* Ticks spent in each phase. */
+struct timing
+  {
+    int64_t insert, hit, miss, delete;
+  };
+
+/* Runs the workload on a chained hash table. */
+static void
+bench_chained (struct timing *t) 
+{
+  struct hash h;
+  struct item probe;
+  int64_t start;
+  int i;
+
+  if (!hash_init (&h, item_hash, item_less, NULL))
+    fail ("hash_init failed");
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    if (hash_insert (&h, &items[i].hash_elem) != NULL)
+      fail ("hash_insert found a duplicate of %d", i);
+  t->insert += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++) 
+    {
+      probe.key = i;
+      if (hash_find (&h, &probe.hash_elem) != &items[i].hash_elem)
+        fail ("hash_find missed %d", i);
+    }
+  t->hit += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++) 
+    {
+      probe.key = ELEM_CNT + i;
+      if (hash_find (&h, &probe.hash_elem) != NULL)
+        fail ("hash_find found absent %d", ELEM_CNT + i);
+    }
+  t->miss += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++) 
+    {
+      probe.key = i;
+      if (hash_delete (&h, &probe.hash_elem) != &items[i].hash_elem)
+        fail ("hash_delete missed %d", i);
+    }
+  t->delete += timer_elapsed (start);
+
+  if (!hash_empty (&h))
+    fail ("chained table not empty after deleting everything");
+  hash_destroy (&h, NULL);
+}
+
+/* Runs the workload on an open-addressing hash table. */
+static void
+bench_open (struct timing *t) 
+{
+  struct ohash h;
+  struct item probe;
+  int64_t start;
+  int i;
+
+  if (!ohash_init (&h, item_ohash, item_oless, NULL))
+    fail ("ohash_init failed");
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    if (ohash_insert (&h, &items[i].ohash_elem) != NULL)
+      fail ("ohash_insert found a duplicate of %d", i);
+  t->insert += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++) 
+    {
+      probe.key = i;
+      if (ohash_find (&h, &probe.ohash_elem) != &items[i].ohash_elem)
+        fail ("ohash_find missed %d", i);
+    }
+  t->hit += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++) 
+    {
+      probe.key = ELEM_CNT + i;
+      if (ohash_find (&h, &probe.ohash_elem) != NULL)
+        fail ("ohash_find found absent %d", ELEM_CNT + i);
+    }
+  t->miss += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++) 
+    {
+      probe.key = i;
+      if (ohash_delete (&h, &probe.ohash_elem) != &items[i].ohash_elem)
+        fail ("ohash_delete missed %d", i);
+    }
+  t->delete += timer_elapsed (start);
+
+  if (!ohash_empty (&h))
+    fail ("open table not empty after deleting everything");
+  ohash_destroy (&h, NULL);
+}
+
+static void
+report (const char *name, const struct timing *t) 
+{
+  msg ("%s: %d x %d inserts %lld, hits %lld, misses %lld, deletes %lld ticks",
+       name, ROUND_CNT, ELEM_CNT, t->insert, t->hit, t->miss, t->delete);
+}
+
+void
+test_hash_bench (void) 
+{
+  struct timing chained = {0, 0, 0, 0};
+  struct timing open = {0, 0, 0, 0};
+  int i;
+
+  for (i = 0; i < ELEM_CNT; i++)
+    items[i].key = i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      bench_chained (&chained);
+      bench_open (&open);
+    }
+
+  report ("chained", &chained);
+  report ("open addressing", &open);
+  pass ();
+}
@@ -0,0 +1,214 @@
+/* Compares a red-black tree with a sorted list, the structure
+   it is meant to replace, on ordered insertions, lookups, range
+   queries, and deletions.  Both structures are checked for
+   correctness as they go.
+
+   Timings are reported in timer ticks and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <list.h>
+#include <random.h>
+#include <rbtree.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+#define ELEM_CNT 1024           /* Elements in each structure. */
+#define RANGE_CNT 16            /* Keys covered by each range query. */
+#define ROUND_CNT 4             /* Times to repeat each workload. */
+
+/* An element that can be in both kinds of structure. */
+struct item
+  {
+    int key;
+    struct list_elem list_elem;
+    struct rb_elem rb_elem;
+  };
+
+static struct item items[ELEM_CNT];
+static int order[ELEM_CNT];
+
+static bool
+item_list_less (const struct list_elem *a, const struct list_elem *b,
+                void *aux UNUSED)
+{
+  return (list_entry (a, struct item, list_elem)->key
+          < list_entry (b, struct item, list_elem)->key);
+}
+
+static bool
+item_rb_less (const struct rb_elem *a, const struct rb_elem *b,
+              void *aux UNUSED)
+{
+  return (rb_entry (a, struct item, rb_elem)->key
+          < rb_entry (b, struct item, rb_elem)->key);
+}
+
+/* Ticks spent in each phase. */
+struct timing
+  {
+    int64_t insert, find, range, delete;
+  };
+
+/* Returns the first element of sorted list L whose key is at
+   least KEY, or the list's end. */
+static struct list_elem *
+list_lower_bound (struct list *l, int key)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (l); e != list_end (l); e = list_next (e))
+    if (list_entry (e, struct item, list_elem)->key >= key)
+      break;
+  return e;
+}
+
+/* Runs the workload on a sorted list. */
+static void
+bench_list (struct timing *t)
+{
+  struct list l;
+  int64_t start;
+  int i;
+
+  list_init (&l);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    list_insert_ordered (&l, &items[order[i]].list_elem,
+                         item_list_less, NULL);
+  t->insert += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      struct list_elem *e = list_lower_bound (&l, 2 * order[i]);
+      if (e != &items[order[i]].list_elem)
+        fail ("list lookup missed %d", 2 * order[i]);
+    }
+  t->find += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i + RANGE_CNT <= ELEM_CNT; i++)
+    {
+      struct list_elem *e = list_lower_bound (&l, 2 * i - 1);
+      int cnt;
+
+      for (cnt = 0; e != list_end (&l); e = list_next (e), cnt++)
+        if (list_entry (e, struct item, list_elem)->key
+            >= 2 * (i + RANGE_CNT))
+          break;
+      if (cnt != RANGE_CNT)
+        fail ("list range at %d has %d elements", 2 * i, cnt);
+    }
+  t->range += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    list_remove (list_lower_bound (&l, 2 * order[i]));
+  t->delete += timer_elapsed (start);
+
+  if (!list_empty (&l))
+    fail ("list not empty after deleting everything");
+}
+
+/* Runs the workload on a red-black tree. */
+static void
+bench_rbtree (struct timing *t)
+{
+  struct rbtree tree;
+  struct item probe;
+  int64_t start;
+  int i;
+
+  rb_init (&tree, item_rb_less, NULL);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    if (rb_insert (&tree, &items[order[i]].rb_elem) != NULL)
+      fail ("rb_insert found a duplicate of %d", 2 * order[i]);
+  t->insert += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      probe.key = 2 * order[i];
+      if (rb_find (&tree, &probe.rb_elem) != &items[order[i]].rb_elem)
+        fail ("rb_find missed %d", probe.key);
+    }
+  t->find += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i + RANGE_CNT <= ELEM_CNT; i++)
+    {
+      struct rb_elem *e;
+      int cnt;
+
+      probe.key = 2 * i - 1;
+      e = rb_lower_bound (&tree, &probe.rb_elem);
+      for (cnt = 0; e != NULL; e = rb_next (e), cnt++)
+        if (rb_entry (e, struct item, rb_elem)->key >= 2 * (i + RANGE_CNT))
+          break;
+      if (cnt != RANGE_CNT)
+        fail ("rbtree range at %d has %d elements", 2 * i, cnt);
+    }
+  t->range += timer_elapsed (start);
+
+  start = timer_ticks ();
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      struct rb_elem *e;
+
+      probe.key = 2 * order[i];
+      e = rb_find (&tree, &probe.rb_elem);
+      if (e == NULL)
+        fail ("rb_find missed %d before deleting it", probe.key);
+      rb_remove (&tree, e);
+    }
+  t->delete += timer_elapsed (start);
+
+  if (!rb_empty (&tree))
+    fail ("tree not empty after deleting everything");
+}
+
+static void
+report (const char *name, const struct timing *t)
+{
+  msg ("%s: %d x %d inserts %lld, finds %lld, ranges %lld, deletes %lld ticks",
+       name, ROUND_CNT, ELEM_CNT, t->insert, t->find, t->range, t->delete);
+}
+
+void
+test_rbtree_bench (void)
+{
+  struct timing list = {0, 0, 0, 0};
+  struct timing tree = {0, 0, 0, 0};
+  int i;
+
+  /* Even keys, inserted and deleted in random order. */
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      items[i].key = 2 * i;
+      order[i] = i;
+    }
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      int j;
+
+      for (j = 0; j < ELEM_CNT; j++)
+        {
+          int k = j + random_ulong () % (ELEM_CNT - j);
+          int t = order[j];
+          order[j] = order[k];
+          order[k] = t;
+        }
+      bench_list (&list);
+      bench_rbtree (&tree);
+    }
+
+  report ("sorted list", &list);
+  report ("red-black tree", &tree);
+  pass ();
+}
@@ -0,0 +1,281 @@
+/* Measures the throughput of memcpy(), memmove(), memset(),
+   memcmp() and strlen() against plain byte-at-a-time loops, for
+   a range of block sizes.  Each run also checks that the library
+   function gets the same answer as the byte loop.
+
+   Before any timing, each function is checked against its byte
+   loop for every size up to SMALL_MAX and every combination of
+   source and destination alignment, which is what exercises the
+   unaligned head and tail paths.
+
+   Timings are reported in timer ticks and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+#define MAX_SIZE 4096           /* Largest block size. */
+#define TOTAL_BYTES (128 << 10) /* Bytes processed per measurement. */
+#define SMALL_MAX 64            /* Largest size checked exhaustively. */
+#define ALIGN_CNT 4             /* Offsets checked for each buffer. */
+
+static unsigned char src[MAX_SIZE + 8];
+static unsigned char dst[MAX_SIZE + 8];
+
+/* What a small check expects in dst, and scratch space. */
+static unsigned char expect[SMALL_MAX + 8];
+static unsigned char tmp[SMALL_MAX];
+
+/* Reference implementations, one byte per iteration. */
+
+static void
+byte_memcpy (unsigned char *d, const unsigned char *s, size_t size) 
+{
+  while (size-- > 0)
+    *d++ = *s++;
+}
+
+static void
+byte_memset (unsigned char *d, int value, size_t size) 
+{
+  while (size-- > 0)
+    *d++ = value;
+}
+
+static int
+byte_memcmp (const unsigned char *a, const unsigned char *b, size_t size) 
+{
+  for (; size-- > 0; a++, b++)
+    if (*a != *b)
+      return *a > *b ? +1 : -1;
+  return 0;
+}
+
+static size_t
+byte_strlen (const char *s) 
+{
+  const char *p;
+
+  for (p = s; *p != '\0'; p++)
+    continue;
+  return p - s;
+}
+
+/* Returns -1, 0 or +1 for negative, zero or positive X. */
+static int
+sign (int x) 
+{
+  return (x > 0) - (x < 0);
+}
+
+/* Fills the start of src and dst with different patterns, copies
+   dst to expect, and stores a null terminator at src[END]. */
+static void
+fill_small (size_t end) 
+{
+  size_t i;
+
+  for (i = 0; i < sizeof expect; i++) 
+    {
+      src[i] = 'a' + i % 26;
+      dst[i] = expect[i] = 'A' + i % 26;
+    }
+  src[end] = '\0';
+}
+
+/* Fails unless dst matches expect, naming the operation
+   OP_NAME that produced it, on SIZE bytes, from source offset
+   SRC_OFS to destination offset DST_OFS. */
+static void
+check_dst (const char *op_name, size_t size, size_t src_ofs, size_t dst_ofs) 
+{
+  if (byte_memcmp (dst, expect, sizeof expect))
+    fail ("%s of %zu bytes from offset %zu to offset %zu is wrong",
+          op_name, size, src_ofs, dst_ofs);
+}
+
+/* Checks memcpy(), memmove(), memset(), memcmp() and strlen()
+   against the byte loops for every size up to SMALL_MAX, every
+   source offset and every destination offset below ALIGN_CNT.
+   Whole buffers are compared, so that writes outside the block
+   show up too. */
+static void
+check_small (void) 
+{
+  size_t size, src_ofs, dst_ofs;
+
+  for (size = 0; size <= SMALL_MAX; size++)
+    for (src_ofs = 0; src_ofs < ALIGN_CNT; src_ofs++)
+      for (dst_ofs = 0; dst_ofs < ALIGN_CNT; dst_ofs++) 
+        {
+          size_t pos[3];
+          size_t i;
+
+          fill_small (SMALL_MAX + 7);
+          byte_memcpy (expect + dst_ofs, src + src_ofs, size);
+          memcpy (dst + dst_ofs, src + src_ofs, size);
+          check_dst ("memcpy", size, src_ofs, dst_ofs);
+
+          /* Within dst, src_ofs that the blocks overlap whenever they
+             are close enough, in either direction. */
+          fill_small (SMALL_MAX + 7);
+          byte_memcpy (tmp, expect + src_ofs, size);
+          byte_memcpy (expect + dst_ofs, tmp, size);
+          memmove (dst + dst_ofs, dst + src_ofs, size);
+          check_dst ("memmove", size, src_ofs, dst_ofs);
+
+          fill_small (SMALL_MAX + 7);
+          byte_memset (expect + dst_ofs, 0x5a, size);
+          memset (dst + dst_ofs, 0x5a, size);
+          check_dst ("memset", size, src_ofs, dst_ofs);
+
+          /* Equal blocks, then blocks that differ in their first,
+             middle or last byte. */
+          fill_small (SMALL_MAX + 7);
+          byte_memcpy (dst + dst_ofs, src + src_ofs, size);
+          if (memcmp (dst + dst_ofs, src + src_ofs, size) != 0)
+            fail ("memcmp of %zu equal bytes from offset %zu "
+                  "to offset %zu is nonzero", size, src_ofs, dst_ofs);
+          pos[0] = 0;
+          pos[1] = size / 2;
+          pos[2] = size - 1;
+          for (i = 0; size > 0 && i < 3; i++) 
+            {
+              unsigned char *d = dst + dst_ofs;
+              const unsigned char *s = src + src_ofs;
+
+              d[pos[i]] ^= 0x80;
+              if (sign (memcmp (d, s, size))
+                  != sign (byte_memcmp (d, s, size))
+                  || sign (memcmp (s, d, size))
+                     != sign (byte_memcmp (s, d, size)))
+                fail ("memcmp of %zu bytes from offset %zu to offset %zu "
+                      "differing at byte %zu is wrong",
+                      size, src_ofs, dst_ofs, pos[i]);
+              d[pos[i]] ^= 0x80;
+            }
+
+          if (dst_ofs == 0) 
+            {
+              fill_small (src_ofs + size);
+              if (strlen ((char *) src + src_ofs) != size)
+                fail ("strlen of %zu bytes at offset %zu is wrong",
+                      size, src_ofs);
+            }
+        }
+}
+
+/* The operations being measured. */
+enum op
+  {
+    OP_MEMCPY,
+    OP_MEMMOVE,
+    OP_MEMSET,
+    OP_MEMCMP,
+    OP_STRLEN,
+    OP_CNT
+  };
+
+static const char *op_names[OP_CNT] =
+  {"memcpy", "memmove", "memset", "memcmp", "strlen"};
+
+/* Performs OP once on SIZE bytes, with the library function if
+   FAST is true or the byte loop otherwise.  Returns a value that
+   depends on the result, for checking. */
+static int
+run_op (enum op op, bool fast, size_t size) 
+{
+  unsigned char *d = dst + 1;
+  const unsigned char *s = src + 1;
+
+  switch (op) 
+    {
+    case OP_MEMCPY:
+      if (fast)
+        memcpy (d, s, size);
+      else
+        byte_memcpy (d, s, size);
+      return d[size / 2];
+    case OP_MEMMOVE:
+      if (fast)
+        memmove (d + 1, d, size - 1);
+      else
+        byte_memcpy (d + 1, s, size - 1);
+      return 0;
+    case OP_MEMSET:
+      if (fast)
+        memset (d, 0x5a, size);
+      else
+        byte_memset (d, 0x5a, size);
+      return d[size - 1];
+    case OP_MEMCMP:
+      return (fast ? memcmp (d, s, size) : byte_memcmp (d, s, size)) + 2;
+    case OP_STRLEN:
+      return fast ? strlen ((char *) s) : byte_strlen ((const char *) s);
+    default:
+      NOT_REACHED ();
+    }
+}
+
+/* Prepares the buffers for OP on SIZE bytes. */
+static void
+setup (enum op op, size_t size) 
+{
+  size_t i;
+
+  for (i = 0; i < sizeof src; i++)
+    src[i] = dst[i] = 'a' + i % 26;
+  if (op == OP_MEMCMP)
+    dst[size] ^= 1;             /* Differ in the last byte compared. */
+  else if (op == OP_STRLEN)
+    src[1 + size] = '\0';
+}
+
+void
+test_string_bench (void) 
+{
+  size_t size;
+
+  check_small ();
+  msg ("small blocks match the byte loops");
+
+  for (size = 16; size <= MAX_SIZE; size *= 4)
+    {
+      int iterations = TOTAL_BYTES / size;
+      enum op op;
+
+      for (op = 0; op < OP_CNT; op++)
+        {
+          int64_t byte_ticks, fast_ticks, start;
+          int expected, actual;
+          int i;
+
+          setup (op, size);
+          expected = run_op (op, false, size);
+          setup (op, size);
+          actual = run_op (op, true, size);
+          if (actual != expected)
+            fail ("%s of %zu bytes returned %d, expected %d",
+                  op_names[op], size, actual, expected);
+          if (op == OP_MEMMOVE && memcmp (dst + 2, src + 1, size - 1))
+            fail ("memmove of %zu overlapping bytes is wrong", size);
+
+          start = timer_ticks ();
+          for (i = 0; i < iterations; i++)
+            run_op (op, false, size);
+          byte_ticks = timer_elapsed (start);
+
+          start = timer_ticks ();
+          for (i = 0; i < iterations; i++)
+            run_op (op, true, size);
+          fast_ticks = timer_elapsed (start);
+
+          msg ("%-7s %4zu bytes: %lld ticks byte loop, %lld ticks library",
+               op_names[op], size, byte_ticks, fast_ticks);
+        }
+    }
+  pass ();
+}
@@ -0,0 +1,218 @@
+/* Microbenchmarks for the reader-writer lock and the sequence
+   lock.  Each benchmark also checks that the primitive under
+   test actually protects its data, failing if a reader ever sees
+   a half-finished update.
+
+   Timings are reported in timer ticks and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8            /* Number of worker threads. */
+#define ITER_CNT 2000           /* Iterations per worker. */
+
+/* Data protected by the primitive under test.  A writer updates
+   both halves; a reader must always see them equal. */
+static struct
+  {
+    int a;
+    int b;
+  }
+shared;
+
+static struct lock lock;
+static struct rwlock rwlock;
+static struct seqlock seqlock;
+static struct semaphore done;
+static int torn_reads;
+
+/* Reader using a plain lock, for comparison. */
+static void
+lock_reader (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      lock_acquire (&lock);
+      if (shared.a != shared.b)
+        torn_reads++;
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
+
+/* Reader using the reader-writer lock. */
+static void
+rwlock_reader (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      rwlock_acquire_read (&rwlock);
+      if (shared.a != shared.b)
+        torn_reads++;
+      rwlock_release_read (&rwlock);
+    }
+  sema_up (&done);
+}
+
+/* Writer using the reader-writer lock.  Yields in the middle of
+   each update to give readers a chance to observe it. */
+static void
+rwlock_writer (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT / 10; i++)
+    {
+      rwlock_acquire_write (&rwlock);
+      shared.a++;
+      thread_yield ();
+      shared.b++;
+      rwlock_release_write (&rwlock);
+    }
+  sema_up (&done);
+}
+
+/* Runs THREAD_CNT copies of READER, plus WRITER_CNT copies of
+   WRITER, and returns the number of ticks until all finish. */
+static int64_t
+run_workers (thread_func *reader, thread_func *writer, int writer_cnt)
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  sema_init (&done, 0);
+  for (i = 0; i < THREAD_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader, NULL);
+  for (i = 0; i < writer_cnt; i++)
+    thread_create ("writer", PRI_DEFAULT, writer, NULL);
+  for (i = 0; i < THREAD_CNT + writer_cnt; i++)
+    sema_down (&done);
+  return timer_elapsed (start);
+}
+
+/* Read-only workload: a plain lock against the read side of a
+   reader-writer lock. */
+void
+test_rwlock_bench_read (void)
+{
+  int64_t lock_ticks, rwlock_ticks;
+
+  lock_init (&lock);
+  rwlock_init (&rwlock);
+  torn_reads = 0;
+
+  lock_ticks = run_workers (lock_reader, NULL, 0);
+  rwlock_ticks = run_workers (rwlock_reader, NULL, 0);
+
+  printf ("lock: %d x %d reads in %lld ticks\n",
+          THREAD_CNT, ITER_CNT, lock_ticks);
+  printf ("rwlock: %d x %d reads in %lld ticks\n",
+          THREAD_CNT, ITER_CNT, rwlock_ticks);
+  rwlock_print_stats (&rwlock, "rwlock");
+
+  if (rwlock.read_acquires != THREAD_CNT * ITER_CNT)
+    fail ("expected %d read acquisitions, got %llu",
+          THREAD_CNT * ITER_CNT, rwlock.read_acquires);
+  if (rwlock.read_contended != 0)
+    fail ("reads contended with no writer present");
+  if (torn_reads != 0)
+    fail ("%d torn reads", torn_reads);
+  pass ();
+}
+
+/* Mixed workload: readers and writers on a reader-writer lock. */
+void
+test_rwlock_bench_write (void)
+{
+  int64_t ticks;
+
+  rwlock_init (&rwlock);
+  shared.a = shared.b = 0;
+  torn_reads = 0;
+
+  ticks = run_workers (rwlock_reader, rwlock_writer, 2);
+
+  printf ("rwlock: %d x %d reads, 2 x %d writes in %lld ticks\n",
+          THREAD_CNT, ITER_CNT, ITER_CNT / 10, ticks);
+  rwlock_print_stats (&rwlock, "rwlock");
+
+  if (shared.a != 2 * (ITER_CNT / 10) || shared.b != shared.a)
+    fail ("lost updates: a=%d, b=%d", shared.a, shared.b);
+  if (torn_reads != 0)
+    fail ("%d torn reads", torn_reads);
+  pass ();
+}
+
+/* Reader using the sequence lock. */
+static void
+seqlock_reader (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      unsigned seq;
+      int a, b;
+
+      do
+        {
+          seq = seqlock_read_begin (&seqlock);
+          a = shared.a;
+          b = shared.b;
+        }
+      while (seqlock_read_retry (&seqlock, seq));
+      if (a != b)
+        torn_reads++;
+    }
+  sema_up (&done);
+}
+
+/* Sole writer for the sequence lock, which therefore needs no
+   further serialization. */
+static void
+seqlock_writer (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT / 10; i++)
+    {
+      seqlock_write_begin (&seqlock);
+      shared.a++;
+      thread_yield ();
+      shared.b++;
+      seqlock_write_end (&seqlock);
+    }
+  sema_up (&done);
+}
+
+/* Mixed workload on a sequence lock. */
+void
+test_seqlock_bench (void)
+{
+  int64_t ticks;
+
+  seqlock_init (&seqlock);
+  shared.a = shared.b = 0;
+  torn_reads = 0;
+
+  ticks = run_workers (seqlock_reader, seqlock_writer, 1);
+
+  printf ("seqlock: %d x %d reads, %d writes in %lld ticks\n",
+          THREAD_CNT, ITER_CNT, ITER_CNT / 10, ticks);
+  seqlock_print_stats (&seqlock, "seqlock");
+
+  if (seqlock.writes != ITER_CNT / 10)
+    fail ("expected %d writes, got %llu", ITER_CNT / 10, seqlock.writes);
+  if (torn_reads != 0)
+    fail ("%d torn reads", torn_reads);
+  pass ();
+}
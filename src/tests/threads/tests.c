@@ -38,6 +38,12 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"rwlock-bench-read", test_rwlock_bench_read},
+    {"rwlock-bench-write", test_rwlock_bench_write},
+    {"seqlock-bench", test_seqlock_bench},
+    {"string-bench", test_string_bench},
+    {"hash-bench", test_hash_bench},
+    {"rbtree-bench", test_rbtree_bench},
   };
 
 static const char *test_name;
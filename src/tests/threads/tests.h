@@ -32,6 +32,12 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_rwlock_bench_read;
+extern test_func test_rwlock_bench_write;
+extern test_func test_seqlock_bench;
+extern test_func test_string_bench;
+extern test_func test_hash_bench;
+extern test_func test_rbtree_bench;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,47 @@
+/* Measures how long writes to the console take, for many short
+   lines written one at a time and for the same lines written in
+   one call.  Writes of this size fit in the serial transmit
+   queue, so neither should have to wait for the serial port.
+
+   Timings are reported in CPU cycles and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LINE_LEN 64             /* Bytes per line, with new-line. */
+#define LINE_CNT 32             /* Lines per timing. */
+
+static char text[LINE_LEN * LINE_CNT];
+
+void
+test_main (void)
+{
+  uint64_t start, lines, block;
+  int i;
+
+  for (i = 0; i < LINE_CNT; i++)
+    {
+      char *line = text + i * LINE_LEN;
+      memset (line, 'a' + i % 26, LINE_LEN - 1);
+      line[LINE_LEN - 1] = '\n';
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < LINE_CNT; i++)
+    if (write (STDOUT_FILENO, text + i * LINE_LEN, LINE_LEN) != LINE_LEN)
+      fail ("short write of line %d", i);
+  lines = rdtsc () - start;
+
+  start = rdtsc ();
+  if (write (STDOUT_FILENO, text, sizeof text) != (int) sizeof text)
+    fail ("short write of %zu bytes", sizeof text);
+  block = rdtsc () - start;
+
+  msg ("%d lines one at a time: %llu cycles", LINE_CNT, lines);
+  msg ("%d lines in one write: %llu cycles", LINE_CNT, block);
+}
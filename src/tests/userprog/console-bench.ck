@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The test writes the same LINE_CNT lines twice, each LINE_LEN - 1
+# copies of one letter.
+my ($lines) = join ('', map ((chr (ord ('a') + $_ % 26) x 63) . "\n", 0...31));
+
+# Timings depend on the speed of the simulator, so only their
+# form is checked.
+s/: \d+ cycles$/: N cycles/ foreach @output;
+compare_output ("run", \@output, [<<EOF]);
+(console-bench) begin
+$lines$lines(console-bench) 32 lines one at a time: N cycles
+(console-bench) 32 lines in one write: N cycles
+(console-bench) end
+console-bench: exit(0)
+EOF
+pass;
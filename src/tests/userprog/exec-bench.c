@@ -0,0 +1,45 @@
+/* Measures the latency of starting a process, as the time taken
+   by exec() and wait() together, in the style of exec-multiple,
+   both with a bare command line and with many arguments.
+
+   Timings are reported in CPU cycles and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 8              /* Processes started per timing. */
+
+/* Runs CMD_LINE to completion EXEC_CNT times and returns the
+   average number of cycles each run took. */
+static uint64_t
+time_exec (const char *cmd_line)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < EXEC_CNT; i++)
+    {
+      pid_t pid = exec (cmd_line);
+      if (pid == PID_ERROR)
+        fail ("exec \"%s\" failed", cmd_line);
+      if (wait (pid) != 81)
+        fail ("wait for \"%s\" returned wrong status", cmd_line);
+    }
+  return (rdtsc () - start) / EXEC_CNT;
+}
+
+void
+test_main (void)
+{
+  uint64_t cycles;
+
+  cycles = time_exec ("child-simple");
+  msg ("no arguments: %llu cycles per exec and wait", cycles);
+
+  cycles = time_exec ("child-simple a b c d e f g h i j k l m n o p "
+                      "q r s t u v w x y z 0 1 2 3 4 5");
+  msg ("32 arguments: %llu cycles per exec and wait", cycles);
+}
@@ -0,0 +1,88 @@
+/* Forks a child that checks it sees a copy of its parent's
+   memory, open files, and system call ring, then scribbles over
+   its copy.  The
+   parent checks that the child's writes did not reach it, as
+   they would if copy-on-write pages were not copied on the
+   first write. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/sample.inc"
+
+/* Spans several pages, so that some are copied and some are
+   left shared. */
+static char buf[3 * 4096];
+static int value = 1;
+
+/* The system call ring, which is not an ordinary page. */
+#define RING_ADDR ((void *) 0x10000000)
+static struct sys_ring *ring = RING_ADDR;
+
+/* Returns true if every byte of BUF is C. */
+static bool
+all (char c)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != c)
+      return false;
+  return true;
+}
+
+/* Runs in the child. */
+static void
+child (int handle)
+{
+  int local = 42;
+  char c;
+
+  if (value != 1 || !all ('p'))
+    fail ("child's memory differs from parent's");
+  if (read (handle, &c, 1) != 1 || c != sample[1])
+    fail ("child's file position differs from parent's");
+  if (ring->sq[0].user_data != 7)
+    fail ("child's ring differs from parent's");
+
+  /* Write to the data segment, the stack, and one page of BUF,
+     including through a system call. */
+  value = 2;
+  local++;
+  memset (buf + 4096, 'c', 4096);
+  ring->sq[0].user_data = 8;
+  if (ring_enter (0) != 0)
+    fail ("child's ring_enter failed");
+  if (read (handle, buf, 1) != 1 || buf[0] != sample[2])
+    fail ("child's read into shared page failed");
+  msg ("child: wrote to its copy");
+  exit (local);
+}
+
+void
+test_main (void)
+{
+  int handle;
+  pid_t pid;
+  char c;
+
+  memset (buf, 'p', sizeof buf);
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (handle, &c, 1) == 1 && c == sample[0], "read first byte");
+  CHECK (ring_setup (RING_ADDR) == 0, "ring_setup");
+  ring->sq[0].user_data = 7;
+
+  /* Say nothing until the child is done, so that the output
+     does not depend on which runs first. */
+  pid = fork ();
+  if (pid == 0)
+    child (handle);
+  if (pid == PID_ERROR)
+    fail ("fork failed");
+  CHECK (wait (pid) == 43, "fork and wait for child");
+  CHECK (value == 1 && all ('p'), "parent's memory unchanged");
+  CHECK (read (handle, &c, 1) == 1 && c == sample[1],
+         "parent's file position unchanged");
+  CHECK (ring->sq[0].user_data == 7, "parent's ring unchanged");
+}
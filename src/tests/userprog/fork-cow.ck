@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-cow) begin
+(fork-cow) open "sample.txt"
+(fork-cow) read first byte
+(fork-cow) ring_setup
+(fork-cow) child: wrote to its copy
+fork-cow: exit(43)
+(fork-cow) fork and wait for child
+(fork-cow) parent's memory unchanged
+(fork-cow) parent's file position unchanged
+(fork-cow) parent's ring unchanged
+(fork-cow) end
+fork-cow: exit(0)
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Writes and reads back data at explicit file offsets with
+   pwrite() and pread(), and checks that neither moves the file
+   position used by read() and write(). */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[128];
+static char readback[128];
+
+void
+test_main (void)
+{
+  int handle;
+  size_t i;
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = i;
+
+  CHECK (create ("pio.dat", 512), "create \"pio.dat\"");
+  CHECK ((handle = open ("pio.dat")) > 1, "open \"pio.dat\"");
+  CHECK (pwrite (handle, buf, sizeof buf, 300) == sizeof buf,
+         "pwrite %zu bytes at offset 300", sizeof buf);
+  CHECK (tell (handle) == 0, "file position still 0");
+  CHECK (pread (handle, readback, sizeof readback, 300) == sizeof readback,
+         "pread %zu bytes at offset 300", sizeof readback);
+  if (memcmp (buf, readback, sizeof buf))
+    fail ("pread data differs from pwrite data");
+  CHECK (tell (handle) == 0, "file position still 0");
+  CHECK (pread (handle, readback, sizeof readback, 450) == 512 - 450,
+         "pread stops at end of file");
+  CHECK (pread (handle, readback, sizeof readback, 600) == 0,
+         "pread past end of file");
+  CHECK (pread (STDOUT_FILENO, readback, 1, 0) == -1, "pread from console");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "pio.dat"
+(pread-pwrite) open "pio.dat"
+(pread-pwrite) pwrite 128 bytes at offset 300
+(pread-pwrite) file position still 0
+(pread-pwrite) pread 128 bytes at offset 300
+(pread-pwrite) file position still 0
+(pread-pwrite) pread stops at end of file
+(pread-pwrite) pread past end of file
+(pread-pwrite) pread from console
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Gathers pieces of data into a file with writev(), scatters
+   them back out with readv() into differently sized buffers, and
+   writes a message to the console with writev(). */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static char a[] = "abc", b[] = "defgh", c[] = "ij";
+  struct iovec out[3] =
+    {
+      {a, 3},
+      {b, 5},
+      {c, 2},
+    };
+  char x[4], y[16];
+  struct iovec in[2] =
+    {
+      {x, sizeof x},
+      {y, sizeof y},
+    };
+  static char head[] = "(readv-writev) writev", tail[] = " to console\n";
+  struct iovec msg_iov[2] =
+    {
+      {head, sizeof head - 1},
+      {tail, sizeof tail - 1},
+    };
+  int handle;
+
+  CHECK (create ("iov.dat", 10), "create \"iov.dat\"");
+  CHECK ((handle = open ("iov.dat")) > 1, "open \"iov.dat\"");
+  CHECK (writev (handle, out, 3) == 10, "writev 3 buffers");
+  CHECK (tell (handle) == 10, "file position is 10");
+
+  seek (handle, 0);
+  CHECK (readv (handle, in, 2) == 10, "readv stops at end of file");
+  if (memcmp (x, "abcd", 4) || memcmp (y, "efghij", 6))
+    fail ("readv data differs from writev data");
+  CHECK (readv (handle, in, 0) == 0, "readv no buffers");
+  CHECK (readv (handle, in, -1) == -1, "readv negative count");
+
+  writev (STDOUT_FILENO, msg_iov, 2);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "iov.dat"
+(readv-writev) open "iov.dat"
+(readv-writev) writev 3 buffers
+(readv-writev) file position is 10
+(readv-writev) readv stops at end of file
+(readv-writev) readv no buffers
+(readv-writev) readv negative count
+(readv-writev) writev to console
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
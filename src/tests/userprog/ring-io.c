@@ -0,0 +1,105 @@
+/* Queues file system calls in a system call ring and has the
+   kernel carry each batch out with a single ring_enter() call,
+   checking the results that come back in the completion queue. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Where the ring is mapped: page-aligned and well clear of the
+   program's code, data, and stack. */
+#define RING_ADDR ((void *) 0x10000000)
+
+static struct sys_ring *ring = RING_ADDR;
+static char buf[4][32];
+static char readback[128];
+
+/* Queues a request and returns it for the caller to fill in. */
+static struct ring_sqe *
+queue (int opcode, unsigned user_data)
+{
+  struct ring_sqe *sqe = &ring->sq[ring->sq_tail++ % RING_ENTRIES];
+
+  memset (sqe, 0, sizeof *sqe);
+  sqe->opcode = opcode;
+  sqe->user_data = user_data;
+  return sqe;
+}
+
+/* Takes the next completion, checks that it belongs to the
+   request tagged USER_DATA, and returns its result. */
+static int
+reap (unsigned user_data)
+{
+  struct ring_cqe *cqe;
+
+  if (ring->cq_head == ring->cq_tail)
+    fail ("completion queue empty, expected %u", user_data);
+  cqe = &ring->cq[ring->cq_head++ % RING_ENTRIES];
+  if (cqe->user_data != user_data)
+    fail ("completion for %u, expected %u", cqe->user_data, user_data);
+  return cqe->res;
+}
+
+void
+test_main (void)
+{
+  struct ring_sqe *sqe;
+  int handle;
+  int i;
+
+  CHECK (ring_enter (1) == -1, "ring_enter without a ring");
+  CHECK (ring_setup ((char *) RING_ADDR + 1) == -1, "ring_setup unaligned");
+  CHECK (ring_setup (RING_ADDR) == 0, "ring_setup");
+  CHECK (ring_setup (RING_ADDR) == -1, "ring_setup twice");
+
+  /* Create and open a file in one batch. */
+  sqe = queue (RING_OP_CREATE, 1);
+  sqe->addr = "ring.dat";
+  sqe->len = sizeof readback;
+  sqe = queue (RING_OP_OPEN, 2);
+  sqe->addr = "ring.dat";
+  CHECK (ring_enter (2) == 2, "submit create and open");
+  CHECK (reap (1) == 1, "create \"ring.dat\"");
+  CHECK ((handle = reap (2)) > 1, "open \"ring.dat\"");
+
+  /* Write four pieces at their offsets, read the whole file back,
+     and close it, all in one batch. */
+  for (i = 0; i < 4; i++)
+    {
+      memset (buf[i], 'a' + i, sizeof buf[i]);
+      sqe = queue (RING_OP_PWRITE, 10 + i);
+      sqe->fd = handle;
+      sqe->addr = buf[i];
+      sqe->len = sizeof buf[i];
+      sqe->offset = i * sizeof buf[i];
+    }
+  sqe = queue (RING_OP_READ, 20);
+  sqe->fd = handle;
+  sqe->addr = readback;
+  sqe->len = sizeof readback;
+  sqe = queue (RING_OP_CLOSE, 21);
+  sqe->fd = handle;
+  CHECK (ring_enter (6) == 6, "submit 4 writes, a read, and a close");
+  for (i = 0; i < 4; i++)
+    if (reap (10 + i) != (int) sizeof buf[i])
+      fail ("pwrite %d was short", i);
+  CHECK (reap (20) == (int) sizeof readback, "read %zu bytes",
+         sizeof readback);
+  if (memcmp (buf, readback, sizeof readback))
+    fail ("data read differs from data written");
+  CHECK (reap (21) == 0, "close");
+
+  /* Requests that fail post their error like any other result. */
+  sqe = queue (RING_OP_READ, 30);
+  sqe->fd = handle;
+  sqe->addr = readback;
+  sqe->len = 1;
+  queue (-1, 31);
+  CHECK (ring_enter (2) == 2, "submit read of closed file and bad opcode");
+  CHECK (reap (30) == -1, "read of closed file fails");
+  CHECK (reap (31) == -1, "bad opcode fails");
+  CHECK (ring_enter (1) == 0, "ring_enter with empty queue");
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-io) begin
+(ring-io) ring_enter without a ring
+(ring-io) ring_setup unaligned
+(ring-io) ring_setup
+(ring-io) ring_setup twice
+(ring-io) submit create and open
+(ring-io) create "ring.dat"
+(ring-io) open "ring.dat"
+(ring-io) submit 4 writes, a read, and a close
+(ring-io) read 128 bytes
+(ring-io) close
+(ring-io) submit read of closed file and bad opcode
+(ring-io) read of closed file fails
+(ring-io) bad opcode fails
+(ring-io) ring_enter with empty queue
+(ring-io) end
+ring-io: exit(0)
+EOF
+pass;
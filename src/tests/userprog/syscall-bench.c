@@ -0,0 +1,57 @@
+/* Measures the latency of a null system call made through
+   `int $0x30' and, if the CPU supports it, through SYSENTER, and
+   checks that system calls with arguments and return values
+   work both ways.
+
+   Timings are reported in CPU cycles and are not checked, since
+   they depend on the speed of the simulator. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 10000          /* Null system calls per timing. */
+
+/* Makes CALL_CNT system calls that do no work and returns the
+   average number of cycles each took.  filesize() on a
+   descriptor that can never be open is the cheapest call there
+   is that returns to the caller. */
+static uint64_t
+time_null_syscall (void)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < CALL_CNT; i++)
+    if (filesize (-1) != -1)
+      fail ("filesize(-1) did not return -1");
+  return (rdtsc () - start) / CALL_CNT;
+}
+
+void
+test_main (void)
+{
+  bool sysenter = syscall_sysenter;
+  uint64_t cycles;
+  int handle;
+
+  syscall_sysenter = false;
+  cycles = time_null_syscall ();
+  msg ("int $0x30: %llu cycles per null system call", cycles);
+
+  if (!sysenter)
+    {
+      msg ("sysenter: not supported by this CPU");
+      return;
+    }
+
+  /* msg() itself now goes through SYSENTER, with a write(). */
+  syscall_sysenter = true;
+  cycles = time_null_syscall ();
+  msg ("sysenter: %llu cycles per null system call", cycles);
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (filesize (handle) > 0, "filesize through sysenter");
+  close (handle);
+}
@@ -0,0 +1,28 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timings depend on the speed of the simulator, so only their
+# form is checked.
+s/: \d+ cycles /: N cycles / foreach @output;
+compare_output ("run", \@output, [<<'EOF', <<'EOF']);
+(syscall-bench) begin
+(syscall-bench) int $0x30: N cycles per null system call
+(syscall-bench) sysenter: N cycles per null system call
+(syscall-bench) open "sample.txt"
+(syscall-bench) filesize through sysenter
+(syscall-bench) end
+syscall-bench: exit(0)
+EOF
+(syscall-bench) begin
+(syscall-bench) int $0x30: N cycles per null system call
+(syscall-bench) sysenter: not supported by this CPU
+(syscall-bench) end
+syscall-bench: exit(0)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Sets the trap flag (TF) and enters the kernel with SYSENTER,
+   which does not clear it, so that the single-step trap arrives
+   on the kernel's first instruction.  The kernel must survive
+   that and hand the trap back to the process, which then dies
+   of it in user mode with a -1 exit code.
+
+   Without SYSENTER, makes the same system call through
+   `int $0x30', which must have the same result. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Sets TF in EFLAGS, so that the instruction after the POPFL
+   that does it is the last to run untrapped. */
+#define SET_TF "pushfl; orl $0x100, (%%esp); popfl; "
+
+void
+test_main (void) 
+{
+  if (syscall_sysenter)
+    asm volatile ("pushl $-1; pushl %[number]; "
+                  "movl %%esp, %%ecx; movl $1f, %%edx; "
+                  SET_TF "sysenter; 1: addl $8, %%esp"
+                  : : [number] "i" (SYS_FILESIZE)
+                  : "eax", "ecx", "edx", "cc", "memory");
+  else
+    asm volatile ("pushl $-1; pushl %[number]; "
+                  SET_TF "int $0x30; addl $8, %%esp"
+                  : : [number] "i" (SYS_FILESIZE)
+                  : "eax", "cc", "memory");
+  fail ("should have died of a debug exception");
+}
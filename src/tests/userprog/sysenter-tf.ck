@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The process must die of the single-step trap, in user mode.
+# The register dump that follows depends on the compiler.
+@output = grep (!/^Interrupt 0x01 \(.*\) at eip=/
+		&& !/^ cr2=.* error=.*/
+		&& !/^ eax=.* ebx=.* ecx=.* edx=.*/
+		&& !/^ esi=.* edi=.* esp=.* ebp=.*/
+		&& !/^ cs=.* ds=.* es=.* ss=.*/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(sysenter-tf) begin
+sysenter-tf: dying due to interrupt 0x01 (#DB Debug Exception).
+sysenter-tf: exit(-1)
+EOF
+pass;
@@ -0,0 +1,55 @@
+/* Forks several children that exit with different codes, then
+   collects them with waitany(), checking that each child is
+   returned exactly once with its own exit code.  The first child
+   forks a child of its own and exits without waiting for it, so
+   that the grandchild is orphaned.  Once every child has been
+   collected, waitany() and wait() must return -1 at once. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 6
+
+void
+test_main (void) 
+{
+  pid_t pids[CHILD_CNT];
+  bool seen[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ();
+      if (pids[i] == 0)
+        {
+          if (i == 0 && fork () == 0)
+            exit (99);
+          exit (10 + i);
+        }
+      CHECK (pids[i] > 0, "fork child %d", i);
+      seen[i] = false;
+    }
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      int status = -1;
+      pid_t pid = waitany (&status);
+      int j;
+
+      for (j = 0; j < CHILD_CNT; j++)
+        if (pids[j] == pid)
+          break;
+      if (j == CHILD_CNT)
+        fail ("waitany() returned %d, which is not a child", pid);
+      if (seen[j])
+        fail ("waitany() returned child %d twice", j);
+      if (status != 10 + j)
+        fail ("child %d exited with %d, not %d", j, status, 10 + j);
+      seen[j] = true;
+    }
+  msg ("collected all children");
+
+  CHECK (waitany (NULL) == -1, "waitany() with no children left");
+  CHECK (wait (pids[0]) == -1, "wait() for a collected child");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(wait-any) begin
+(wait-any) fork child 0
+(wait-any) fork child 1
+(wait-any) fork child 2
+(wait-any) fork child 3
+(wait-any) fork child 4
+(wait-any) fork child 5
+(wait-any) collected all children
+(wait-any) waitany() with no children left
+(wait-any) wait() for a collected child
+(wait-any) end
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Runs child-linear, which needs more memory than fits in RAM,
+   many times in a row.  A kernel that does not give back the
+   frame and swap table entries of processes that have exited
+   runs out of swap before the last child. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 12
+
+void
+test_main (void)
+{
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pid_t child;
+
+      child = exec ("child-linear");
+      if (child == -1)
+        fail ("exec \"child-linear\" %d failed", i);
+      if (wait (child) != 0x42)
+        fail ("child %d failed", i);
+    }
+  msg ("ran %d children", CHILD_CNT);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-exit-many) begin
+(page-exit-many) ran 12 children
+(page-exit-many) end
+EOF
+pass;
@@ -0,0 +1,193 @@
+#include "threads/idle.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+/* Idle-time support for the idle thread.
+
+   When no thread is ready, the idle thread calls idle_halt().
+   Before halting the CPU it runs any deferred work that has come
+   due, so that non-urgent periodic jobs only cost time the CPU
+   would otherwise have spent halted.  Then, unless disabled, it
+   slows the timer down by a factor of TIMER_IDLE_STRIDE, so that
+   a mostly idle machine takes far fewer timer interrupts, and
+   halts until the next interrupt.  idle_leave() puts the timer
+   back to full speed as soon as the CPU has real work again. */
+
+/* If true (default), slow the timer down while idle.
+   Controlled by kernel command-line option "-fixedtick". */
+bool idle_dynamic_ticks = true;
+
+/* Deferred work, in no particular order.
+   Protected by disabling interrupts. */
+static struct list work_list = LIST_INITIALIZER (work_list);
+
+/* True while halted, until idle_leave() is called. */
+static bool halted;
+
+/* Tick at which the current halt began. */
+static int64_t halt_start;
+
+/* Statistics. */
+static long long halt_cnt;      /* # of times the CPU was halted. */
+static long long halt_ticks;    /* # of timer ticks spent halted. */
+static long long work_cnt;      /* # of deferred work items run. */
+
+static bool run_due_work (void);
+
+/* Arranges for FUNCTION to be called with AUX by the idle
+   thread, starting the next time the CPU is idle, and then again
+   whenever the CPU is idle at least PERIOD ticks after the
+   previous run.  A PERIOD of 0 runs FUNCTION only once.  WORK
+   must remain valid until it has run or has been cancelled.
+
+   This function may be called from an interrupt handler. */
+void
+idle_work_add (struct idle_work *work, idle_work_func *function, void *aux,
+               int64_t period)
+{
+  enum intr_level old_level;
+
+  ASSERT (work != NULL);
+  ASSERT (function != NULL);
+  ASSERT (period >= 0);
+
+  work->function = function;
+  work->aux = aux;
+  work->period = period;
+  work->due = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&work_list, &work->elem);
+  intr_set_level (old_level);
+}
+
+/* Cancels WORK, which must have been added with idle_work_add()
+   and must not already have run, if it runs only once. */
+void
+idle_work_cancel (struct idle_work *work)
+{
+  enum intr_level old_level;
+
+  ASSERT (work != NULL);
+
+  old_level = intr_disable ();
+  list_remove (&work->elem);
+  intr_set_level (old_level);
+}
+
+/* Called by the idle thread, with interrupts off, when no other
+   thread is ready to run.  Runs deferred work that has come due
+   and returns, since that work may have readied a thread.
+   Otherwise, halts the CPU until the next interrupt, returning
+   with interrupts on. */
+void
+idle_halt (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (run_due_work ())
+    return;
+
+  /* Delayed work needs the timer at full resolution. */
+  if (idle_dynamic_ticks && !workqueue_timer_pending ())
+    timer_slow_down ();
+  halted = true;
+  halt_start = timer_ticks ();
+  halt_cnt++;
+
+  /* Re-enable interrupts and wait for the next one.
+
+     The `sti' instruction disables interrupts until the
+     completion of the next instruction, so these two
+     instructions are executed atomically.  This atomicity is
+     important; otherwise, an interrupt could be handled
+     between re-enabling interrupts and waiting for the next
+     one to occur, wasting as much as one clock tick worth of
+     time.
+
+     See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
+     7.11.1 "HLT Instruction". */
+  asm volatile ("sti; hlt" : : : "memory");
+
+  intr_disable ();
+  idle_leave ();
+  intr_enable ();
+}
+
+/* Ends the current halt, if any: restores the full timer rate
+   and accounts for the time spent halted.  Called by the idle
+   thread when it wakes up, and by the scheduler when it switches
+   away from the idle thread, which can happen before the idle
+   thread gets control back if an interrupt handler yields.  Must
+   be called with interrupts off. */
+void
+idle_leave (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (halted)
+    {
+      halted = false;
+      timer_speed_up ();
+      halt_ticks += timer_ticks () - halt_start;
+    }
+}
+
+/* Prints idle statistics. */
+void
+idle_print_stats (void)
+{
+  int64_t total = timer_ticks ();
+
+  printf ("Idle: %lld halts, %lld ticks halted (%lld%% of run time), "
+          "%lld deferred jobs\n", halt_cnt, halt_ticks,
+          total > 0 ? halt_ticks * 100 / total : 0, work_cnt);
+}
+
+/* Runs every deferred work item that has come due, with
+   interrupts on.  Returns true if any ran.  Must be called with
+   interrupts off, and returns with interrupts off. */
+static bool
+run_due_work (void)
+{
+  bool ran = false;
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (e = list_begin (&work_list); e != list_end (&work_list); )
+    {
+      struct idle_work *w = list_entry (e, struct idle_work, elem);
+      int64_t now = timer_ticks ();
+
+      if (now < w->due)
+        {
+          e = list_next (e);
+          continue;
+        }
+
+      /* Reschedule or retire W before running it, so that the
+         function may add or cancel work itself. */
+      if (w->period > 0)
+        {
+          w->due = now + w->period;
+          e = list_next (e);
+        }
+      else
+        e = list_remove (e);
+
+      intr_enable ();
+      w->function (w->aux);
+      intr_disable ();
+
+      work_cnt++;
+      ran = true;
+
+      /* The list may have changed while interrupts were on. */
+      e = list_begin (&work_list);
+    }
+  return ran;
+}
@@ -0,0 +1,37 @@
+#ifndef THREADS_IDLE_H
+#define THREADS_IDLE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Deferred work run by the idle thread.
+
+   The function runs in the idle thread with interrupts on, so it
+   must not sleep: it may not acquire locks, down semaphores, or
+   do anything else that could block.  Work that needs to sleep
+   should hand itself off to a kernel thread instead. */
+typedef void idle_work_func (void *aux);
+
+struct idle_work
+  {
+    struct list_elem elem;      /* Element in the idle work list. */
+    idle_work_func *function;   /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNCTION. */
+    int64_t period;             /* Ticks between runs; 0 to run once. */
+    int64_t due;                /* Tick at which to run next. */
+  };
+
+/* If true (default), slow the timer down while idle.
+   Controlled by kernel command-line option "-fixedtick". */
+extern bool idle_dynamic_ticks;
+
+void idle_work_add (struct idle_work *, idle_work_func *, void *aux,
+                    int64_t period);
+void idle_work_cancel (struct idle_work *);
+
+void idle_halt (void);
+void idle_leave (void);
+void idle_print_stats (void);
+
+#endif /* threads/idle.h */
@@ -15,13 +15,17 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/idle.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/memtag.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -63,6 +67,7 @@ static void paging_init (void);
 static char **read_command_line (void);
 static char **parse_options (char **argv);
 static void run_actions (char **argv);
+static void run_memstat (char **argv);
 static void usage (void);
 
 #ifdef FILESYS
@@ -113,10 +118,12 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  process_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
+  workqueue_start ();
   serial_init_queue ();
   timer_calibrate ();
 
@@ -256,6 +263,23 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-lockprof"))
+        synch_profiling = true;
+      else if (!strcmp (name, "-fixedtick"))
+        idle_dynamic_ticks = false;
+      else if (!strcmp (name, "-memtag"))
+        memtag_enabled = true;
+      else if (!strcmp (name, "-poolreserve"))
+        {
+          int pct = value != NULL ? atoi (value) : -1;
+          if (pct < 0 || pct > 100)
+            PANIC ("-poolreserve takes a percentage from 0 to 100");
+          palloc_lend_reserve = pct;
+        }
+      else if (!strcmp (name, "-noprezero"))
+        palloc_prezero = false;
+      else if (!strcmp (name, "-novga"))
+        console_vga = false;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -292,6 +316,16 @@ run_task (char **argv)
   printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Prints kernel memory usage by allocation tag. */
+static void
+run_memstat (char **argv UNUSED) 
+{
+  if (memtag_enabled)
+    memtag_print_stats ();
+  else
+    printf ("Memory tagging is off (use -memtag).\n");
+}
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -309,6 +343,7 @@ run_actions (char **argv)
   static const struct action actions[] = 
     {
       {"run", 2, run_task},
+      {"memstat", 1, run_memstat},
 #ifdef FILESYS
       {"ls", 1, fsutil_ls},
       {"cat", 2, fsutil_cat},
@@ -357,6 +392,7 @@ usage (void)
 #else
           "  run TEST           Run TEST.\n"
 #endif
+          "  memstat            Print kernel memory use by source file.\n"
 #ifdef FILESYS
           "  ls                 List files in the root directory.\n"
           "  cat FILE           Print FILE to the console.\n"
@@ -379,6 +415,12 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -lockprof          Report lock contention at shutdown.\n"
+          "  -fixedtick         Keep the timer at full rate while idle.\n"
+          "  -memtag            Account kernel memory by source file.\n"
+          "  -poolreserve=PCT   Never lend PCT%% of a page pool (def. 25).\n"
+          "  -noprezero         Don't zero user pages in advance while idle.\n"
+          "  -novga             Write the console to the serial port only.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
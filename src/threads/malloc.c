@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
+#include "threads/memtag.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -28,12 +30,36 @@
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
+   Each descriptor also has a small "magazine" of free blocks
+   in front of its free list, protected by disabling interrupts
+   rather than by the descriptor's lock.  malloc() and free()
+   normally just pop from or push onto the magazine.  Only when
+   the magazine runs empty (or full) do they take the lock and
+   move half a magazine's worth of blocks from (or to) the free
+   list in one batch, so that a block allocated and freed over
+   and over never touches the lock at all.
+
+   Finally, an arena whose blocks all become free is not given
+   back right away: each descriptor keeps up to ARENA_SPARE empty
+   arenas around, so that a workload that hovers around an arena
+   boundary does not call the page allocator on every round.
+
+   When memory tagging is enabled, every block is preceded by a
+   header that records the tag it was charged to and the size
+   that was asked for, so that free() can credit the tag.
+
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
    the beginning of the allocated block's arena header. */
 
+/* Maximum number of blocks in a magazine. */
+#define MAG_SIZE 16
+
+/* Number of empty arenas a descriptor keeps before freeing. */
+#define ARENA_SPARE 1
+
 /* Descriptor. */
 struct desc
   {
@@ -41,6 +67,21 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    char name[16];              /* Lock name, for profiling. */
+    size_t empty_cnt;           /* Arenas with no blocks in use. */
+
+    /* Magazine.  Protected by disabling interrupts. */
+    void *mag[MAG_SIZE];        /* Free blocks. */
+    size_t mag_cnt;             /* Number of blocks in MAG. */
+    size_t mag_max;             /* Capacity of MAG, at most MAG_SIZE. */
+
+    /* Statistics. */
+    unsigned long long mallocs;         /* Blocks allocated. */
+    unsigned long long mag_hits;        /* ...served by the magazine. */
+    unsigned long long refills;         /* Magazine refills. */
+    unsigned long long drains;          /* Magazine drains. */
+    unsigned long long arenas_alloced;  /* Arenas obtained. */
+    unsigned long long arenas_freed;    /* Arenas given back. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -60,12 +101,23 @@ struct block
     struct list_elem free_elem; /* Free list element. */
   };
 
+/* Precedes each block when memory tagging is enabled. */
+struct tag_header
+  {
+    int tag;                    /* Tag charged for the block. */
+    size_t size;                /* Requested size in bytes. */
+  };
+
 /* Our set of descriptors. */
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static void *alloc_block (size_t size);
+static void free_block (void *);
+static bool refill (struct desc *);
+static void drain (struct desc *, struct block *);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -81,17 +133,66 @@ malloc_init (void)
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
       list_init (&d->free_list);
       lock_init (&d->lock);
+      snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+      lock_set_name (&d->lock, d->name);
+      d->empty_cnt = 0;
+      d->mag_cnt = 0;
+      d->mag_max = d->blocks_per_arena / 2;
+      if (d->mag_max > MAG_SIZE)
+        d->mag_max = MAG_SIZE;
+      if (d->mag_max < 1)
+        d->mag_max = 1;
     }
 }
 
+/* Prints statistics for each descriptor that has been used. */
+void
+malloc_print_stats (void) 
+{
+  struct desc *d;
+
+  for (d = descs; d < descs + desc_cnt; d++)
+    if (d->mallocs > 0)
+      printf ("Malloc %zu: %llu allocs (%llu from magazine), "
+              "%llu refills, %llu drains, %llu/%llu arenas "
+              "allocated/freed\n",
+              d->block_size, d->mallocs, d->mag_hits, d->refills,
+              d->drains, d->arenas_alloced, d->arenas_freed);
+}
+
+/* Obtains and returns a new block of at least SIZE bytes,
+   charging it to TAG.  Returns a null pointer if memory is not
+   available. */
+void *
+malloc_tagged (size_t size, const char *tag) 
+{
+  struct tag_header *h;
+
+  if (!memtag_enabled)
+    return alloc_block (size);
+
+  /* A null pointer satisfies a request for 0 bytes. */
+  if (size == 0)
+    return NULL;
+
+  h = alloc_block (size + sizeof *h);
+  if (h == NULL)
+    return NULL;
+  h->tag = memtag_lookup (tag, MEMTAG_MALLOC);
+  h->size = size;
+  memtag_alloc (h->tag, size);
+  return h + 1;
+}
+
 /* Obtains and returns a new block of at least SIZE bytes.
    Returns a null pointer if memory is not available. */
-void *
-malloc (size_t size) 
+static void *
+alloc_block (size_t size) 
 {
   struct desc *d;
   struct block *b;
   struct arena *a;
+  bool refilled;
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
@@ -119,44 +220,32 @@ malloc (size_t size)
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
+  /* Take a block from the magazine, refilling it first if it's
+     empty. */
+  for (refilled = false; ; refilled = true) 
     {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
+      enum intr_level old_level = intr_disable ();
+      if (d->mag_cnt > 0) 
         {
-          lock_release (&d->lock);
-          return NULL; 
+          b = d->mag[--d->mag_cnt];
+          d->mallocs++;
+          if (!refilled)
+            d->mag_hits++;
+          intr_set_level (old_level);
+          return b;
         }
+      intr_set_level (old_level);
 
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
+      if (!refill (d))
+        return NULL;
     }
-
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
-  lock_release (&d->lock);
-  return b;
 }
 
-/* Allocates and return A times B bytes initialized to zeroes.
-   Returns a null pointer if memory is not available. */
+/* Allocates and return A times B bytes initialized to zeroes,
+   charging them to TAG.  Returns a null pointer if memory is not
+   available. */
 void *
-calloc (size_t a, size_t b) 
+calloc_tagged (size_t a, size_t b, const char *tag) 
 {
   void *p;
   size_t size;
@@ -167,7 +256,7 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = malloc_tagged (size, tag);
   if (p != NULL)
     memset (p, 0, size);
 
@@ -179,20 +268,25 @@ static size_t
 block_size (void *block) 
 {
   struct block *b = block;
-  struct arena *a = block_to_arena (b);
-  struct desc *d = a->desc;
+  struct arena *a;
+  struct desc *d;
 
+  if (memtag_enabled)
+    return ((struct tag_header *) block - 1)->size;
+
+  a = block_to_arena (b);
+  d = a->desc;
   return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
 }
 
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
-   moving it in the process.
+   moving it in the process, and charging it to TAG.
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
    A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
 void *
-realloc (void *old_block, size_t new_size) 
+realloc_tagged (void *old_block, size_t new_size, const char *tag) 
 {
   if (new_size == 0) 
     {
@@ -201,7 +295,7 @@ realloc (void *old_block, size_t new_size)
     }
   else 
     {
-      void *new_block = malloc (new_size);
+      void *new_block = malloc_tagged (new_size, tag);
       if (old_block != NULL && new_block != NULL)
         {
           size_t old_size = block_size (old_block);
@@ -217,6 +311,21 @@ realloc (void *old_block, size_t new_size)
    malloc(), calloc(), or realloc(). */
 void
 free (void *p) 
+{
+  if (p != NULL && memtag_enabled)
+    {
+      struct tag_header *h = (struct tag_header *) p - 1;
+      memtag_free (h->tag, h->size);
+      free_block (h);
+    }
+  else
+    free_block (p);
+}
+
+/* Frees block P, which must have been obtained from
+   alloc_block(). */
+static void
+free_block (void *p) 
 {
   if (p != NULL)
     {
@@ -233,26 +342,17 @@ free (void *p)
           memset (b, 0xcc, d->block_size);
 #endif
   
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
-
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
+          enum intr_level old_level = intr_disable ();
+          if (d->mag_cnt < d->mag_max)
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              d->mag[d->mag_cnt++] = b;
+              intr_set_level (old_level);
+            }
+          else
+            {
+              intr_set_level (old_level);
+              drain (d, b);
             }
-
-          lock_release (&d->lock);
         }
       else
         {
@@ -263,6 +363,117 @@ free (void *p)
     }
 }
 
+/* Moves up to half a magazine's worth of blocks from D's free
+   list into its magazine, creating a new arena if the free list
+   is empty.  Returns false if memory is not available. */
+static bool
+refill (struct desc *d) 
+{
+  size_t want = (d->mag_max + 1) / 2;
+  enum intr_level old_level;
+
+  lock_acquire (&d->lock);
+
+  /* If the free list is empty, create a new arena. */
+  if (list_empty (&d->free_list))
+    {
+      struct arena *a;
+      size_t i;
+
+      /* Allocate a page. */
+      a = palloc_get_page (0);
+      if (a == NULL) 
+        {
+          lock_release (&d->lock);
+          return false; 
+        }
+
+      /* Initialize arena and add its blocks to the free list. */
+      a->magic = ARENA_MAGIC;
+      a->desc = d;
+      a->free_cnt = d->blocks_per_arena;
+      for (i = 0; i < d->blocks_per_arena; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_push_back (&d->free_list, &b->free_elem);
+        }
+      d->empty_cnt++;
+      d->arenas_alloced++;
+    }
+
+  /* Move blocks into the magazine.  Another thread may have
+     freed blocks into it since we found it empty, so stop when
+     it fills up. */
+  old_level = intr_disable ();
+  d->refills++;
+  while (want-- > 0 && d->mag_cnt < d->mag_max
+         && !list_empty (&d->free_list)) 
+    {
+      struct block *b = list_entry (list_pop_front (&d->free_list),
+                                    struct block, free_elem);
+      struct arena *a = block_to_arena (b);
+      if (a->free_cnt-- == d->blocks_per_arena)
+        d->empty_cnt--;
+      d->mag[d->mag_cnt++] = b;
+    }
+  intr_set_level (old_level);
+
+  lock_release (&d->lock);
+  return true;
+}
+
+/* Returns block B, along with half of the blocks in D's full
+   magazine, to D's free list, freeing arenas that become empty
+   beyond the ARENA_SPARE that D keeps. */
+static void
+drain (struct desc *d, struct block *b) 
+{
+  struct block *batch[MAG_SIZE / 2 + 1];
+  size_t batch_cnt = 0;
+  enum intr_level old_level;
+  size_t i;
+
+  /* Take blocks out of the magazine.  It may no longer be full by
+     now, in which case we drain whatever half of it there is. */
+  batch[batch_cnt++] = b;
+  old_level = intr_disable ();
+  d->drains++;
+  for (i = 0; i < d->mag_max / 2 && d->mag_cnt > 0; i++)
+    batch[batch_cnt++] = d->mag[--d->mag_cnt];
+  intr_set_level (old_level);
+
+  lock_acquire (&d->lock);
+  for (i = 0; i < batch_cnt; i++) 
+    {
+      struct arena *a = block_to_arena (batch[i]);
+
+      /* Add block to free list. */
+      list_push_front (&d->free_list, &batch[i]->free_elem);
+
+      /* If the arena is now entirely unused, keep it as a spare or
+         free it. */
+      if (++a->free_cnt >= d->blocks_per_arena) 
+        {
+          ASSERT (a->free_cnt == d->blocks_per_arena);
+          if (d->empty_cnt < ARENA_SPARE)
+            d->empty_cnt++;
+          else
+            {
+              size_t j;
+
+              for (j = 0; j < d->blocks_per_arena; j++) 
+                {
+                  struct block *b = arena_to_block (a, j);
+                  list_remove (&b->free_elem);
+                }
+              palloc_free_page (a);
+              d->arenas_freed++;
+            }
+        }
+    }
+  lock_release (&d->lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
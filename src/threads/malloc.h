@@ -5,9 +5,17 @@
 #include <stddef.h>
 
 void malloc_init (void);
-void *malloc (size_t) __attribute__ ((malloc));
-void *calloc (size_t, size_t) __attribute__ ((malloc));
-void *realloc (void *, size_t);
+void malloc_print_stats (void);
+void *malloc_tagged (size_t, const char *tag) __attribute__ ((malloc));
+void *calloc_tagged (size_t, size_t, const char *tag)
+  __attribute__ ((malloc));
+void *realloc_tagged (void *, size_t, const char *tag);
 void free (void *);
 
+/* Allocations are charged to the calling source file when
+   memory tagging is enabled.  See threads/memtag.c. */
+#define malloc(SIZE) malloc_tagged (SIZE, __FILE__)
+#define calloc(A, B) calloc_tagged (A, B, __FILE__)
+#define realloc(BLOCK, SIZE) realloc_tagged (BLOCK, SIZE, __FILE__)
+
 #endif /* threads/malloc.h */
@@ -0,0 +1,159 @@
+#include "threads/memtag.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "threads/interrupt.h"
+
+/* Kernel memory accounting.
+
+   When enabled, malloc() and the page allocator charge every
+   allocation to a "tag", which is the name of the source file
+   that asked for the memory.  (The allocators' interfaces are
+   macros that pass along __FILE__, so callers need not do
+   anything.)  For each tag we keep the bytes and objects
+   currently allocated, the high-water mark of bytes, and the
+   total number of allocations.  (For palloc tags, each page
+   counts as one object.)  Objects that are never freed
+   show up as live objects at shutdown, which makes leaks
+   visible, and the high-water marks show how much of each pool
+   a workload really needs.
+
+   Tags are kept in a small fixed table, because they must be
+   usable before malloc() itself is.  Allocations beyond the
+   table's capacity are charged to tag 0, "(other)".  The table
+   is protected by disabling interrupts, since the page allocator
+   must be usable from the scheduler. */
+
+/* If true, malloc() and palloc tag each allocation with the
+   source file that made it. */
+bool memtag_enabled;
+
+/* An allocation tag. */
+struct memtag
+  {
+    const char *name;           /* Source file name. */
+    enum memtag_kind kind;      /* Kind of memory. */
+    size_t bytes;               /* Bytes currently allocated. */
+    size_t max_bytes;           /* High-water mark of BYTES. */
+    size_t objs;                /* Objects currently allocated. */
+    unsigned long long allocs;  /* Total allocations. */
+  };
+
+/* Tag table.  Tag 0 collects allocations that did not fit. */
+#define TAG_CNT 64
+static struct memtag tags[TAG_CNT] = { { "(other)", MEMTAG_MALLOC,
+                                         0, 0, 0, 0 } };
+
+/* Returns the tag for allocations of KIND made by source file
+   NAME, creating it if necessary.  NAME must remain valid as long
+   as the kernel runs, which __FILE__ does. */
+int
+memtag_lookup (const char *name, enum memtag_kind kind) 
+{
+  enum intr_level old_level;
+  int tag;
+
+  /* Build paths look like "../../threads/init.c".  Drop the
+     leading "../" parts. */
+  while (name[0] == '.' && name[1] == '.' && name[2] == '/')
+    name += 3;
+
+  old_level = intr_disable ();
+  for (tag = 1; tag < TAG_CNT; tag++)
+    if (tags[tag].name == NULL)
+      {
+        tags[tag].name = name;
+        tags[tag].kind = kind;
+        break;
+      }
+    else if (tags[tag].kind == kind
+             && (tags[tag].name == name || !strcmp (tags[tag].name, name)))
+      break;
+  intr_set_level (old_level);
+
+  return tag < TAG_CNT ? tag : 0;
+}
+
+/* Charges an allocation of BYTES bytes to TAG. */
+void
+memtag_alloc (int tag, size_t bytes) 
+{
+  struct memtag *t = &tags[tag];
+  enum intr_level old_level;
+
+  ASSERT (tag >= 0 && tag < TAG_CNT);
+
+  old_level = intr_disable ();
+  t->bytes += bytes;
+  if (t->bytes > t->max_bytes)
+    t->max_bytes = t->bytes;
+  t->objs++;
+  t->allocs++;
+  intr_set_level (old_level);
+}
+
+/* Credits TAG with the freeing of BYTES bytes. */
+void
+memtag_free (int tag, size_t bytes) 
+{
+  struct memtag *t = &tags[tag];
+  enum intr_level old_level;
+
+  ASSERT (tag >= 0 && tag < TAG_CNT);
+
+  old_level = intr_disable ();
+  ASSERT (t->bytes >= bytes && t->objs > 0);
+  t->bytes -= bytes;
+  t->objs--;
+  intr_set_level (old_level);
+}
+
+/* Orders tags by decreasing high-water mark. */
+static int
+compare_tags (const void *a_, const void *b_) 
+{
+  const struct memtag *a = *(const struct memtag **) a_;
+  const struct memtag *b = *(const struct memtag **) b_;
+
+  if (a->max_bytes != b->max_bytes)
+    return a->max_bytes < b->max_bytes ? 1 : -1;
+  return strcmp (a->name, b->name);
+}
+
+/* Prints memory usage by tag. */
+void
+memtag_print_stats (void) 
+{
+  struct memtag copy[TAG_CNT];
+  struct memtag *sorted[TAG_CNT];
+  enum intr_level old_level;
+  size_t cnt, i;
+
+  if (!memtag_enabled)
+    return;
+
+  /* Take a snapshot, so that the numbers are consistent with one
+     another and don't change as printf() allocates. */
+  old_level = intr_disable ();
+  memcpy (copy, tags, sizeof tags);
+  intr_set_level (old_level);
+
+  cnt = 0;
+  for (i = 0; i < TAG_CNT && copy[i].name != NULL; i++)
+    if (copy[i].allocs > 0)
+      sorted[cnt++] = &copy[i];
+  qsort (sorted, cnt, sizeof *sorted, compare_tags);
+
+  printf ("Memory tags: %zu active tags\n", cnt);
+  printf ("  %-24s %6s %10s %8s %10s %10s\n",
+          "tag", "kind", "bytes", "objects", "max bytes", "allocs");
+  for (i = 0; i < cnt; i++)
+    {
+      struct memtag *t = sorted[i];
+      printf ("  %-24s %6s %10zu %8zu %10zu %10llu\n", t->name,
+              t->kind == MEMTAG_MALLOC ? "malloc" : "palloc",
+              t->bytes, t->objs, t->max_bytes, t->allocs);
+    }
+}
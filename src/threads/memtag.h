@@ -0,0 +1,27 @@
+#ifndef THREADS_MEMTAG_H
+#define THREADS_MEMTAG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Kernel memory accounting.  See memtag.c for details. */
+
+/* If true, malloc() and palloc tag each allocation with the
+   source file that made it.  Controlled by kernel command-line
+   option "-memtag", which must be seen before the allocators are
+   initialized. */
+extern bool memtag_enabled;
+
+/* Kind of memory a tag accounts for. */
+enum memtag_kind
+  {
+    MEMTAG_MALLOC,              /* Bytes from malloc(). */
+    MEMTAG_PALLOC               /* Pages from the page allocator. */
+  };
+
+int memtag_lookup (const char *name, enum memtag_kind);
+void memtag_alloc (int tag, size_t bytes);
+void memtag_free (int tag, size_t bytes);
+void memtag_print_stats (void);
+
+#endif /* threads/memtag.h */
@@ -2,15 +2,21 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/idle.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
+#include "threads/memtag.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
+#ifdef USERPROG
 #include "userprog/process.h"
+#endif
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -23,23 +29,129 @@
    even if user processes are swapping like mad.
 
    By default, half of system RAM is given to the kernel pool and
-   half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   half to the user pool.  That split is only a starting point:
+   when one pool runs out, it borrows pages from the other, as
+   long as the lender keeps at least palloc_lend_reserve percent
+   of its own pages free.  Borrowed pages go back to the pool
+   they came from when they are freed.
+
+   The kernel wants its pages back once user processes hold
+   pages borrowed from the kernel pool and the kernel pool's own
+   free pages drop to its reserve.  Eviction allocates, takes
+   locks, and does swap I/O, which the palloc_get_*() functions
+   cannot do, since the slab and malloc code call them with
+   allocator locks held.  So they queue reclaim_lent() on
+   system_wq instead, which evicts lent frames in a worker thread
+   until the kernel pool is back above its reserve.  get_page(),
+   whose callers hold no allocator locks, also evicts lent frames
+   itself rather than fail.
+
+   Each pool is managed as a binary buddy system.  Free memory is
+   kept as blocks of 2**K pages, for K from 0 to MAX_ORDER, each
+   aligned (relative to the pool's base) to its own size, on one
+   free list per order.  A request for N pages takes the
+   smallest block of at least N pages, splitting larger blocks
+   in half as needed, and gives the pages beyond N straight back.
+   Freeing a block merges it with its "buddy", the other half of
+   the block it was split from, for as long as the buddy is free
+   too.  Allocation and freeing are therefore O(log n) instead of
+   a linear bitmap scan, and free space stays coalesced.
+
+   Pools are protected by disabling interrupts rather than by a
+   lock, because pages are freed from inside the scheduler, where
+   sleeping is not an option.
+
+   Demand-zero faults and stack growth want single zeroed user
+   pages, and would rather not wait for them to be cleared.  So
+   while the CPU is idle, we zero up to PREZERO_MAX free user
+   pages ahead of time and set them aside, and hand those out for
+   PAL_USER | PAL_ZERO requests.  The set-aside pages are still
+   used for any single-page user request once the user pool is
+   otherwise exhausted.
+
+   A page can be shared, for example by processes that map the
+   same frame copy-on-write after fork().  palloc_share_page()
+   adds a reference to a page, and palloc_free_page() drops one,
+   only freeing the page when the last reference goes. */
+
+/* Largest block order: blocks are at most 2**MAX_ORDER pages. */
+#define MAX_ORDER 10
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
+    const char *name;                   /* Name, for statistics. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
+    uint8_t *free_order;                /* Per page: K + 1 if the page
+                                           starts a free block of order K,
+                                           otherwise 0. */
+    struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+    size_t free_blocks[MAX_ORDER + 1];  /* Length of each free list. */
+    struct bitmap *lent_map;            /* Pages lent to the other pool. */
+    uint8_t *share_cnt;                 /* Per page: references beyond
+                                           the first. */
+    uint8_t *page_tag;                  /* Per page: memory tag charged
+                                           for it, if tagging is on. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages in pool. */
+    size_t free_cnt;                    /* Number of free pages. */
+    size_t lent_cnt;                    /* Pages lent to the other pool. */
+
+    /* Statistics. */
+    unsigned long long splits;          /* Blocks split in two. */
+    unsigned long long merges;          /* Buddies merged. */
+    unsigned long long failures;        /* Requests that failed. */
+    unsigned long long lends;           /* Requests served for the
+                                           other pool. */
+    unsigned long long reclaims;        /* Lent frames evicted to get
+                                           pages back. */
+  };
+
+/* A free block, stored in its own first page. */
+struct free_block
+  {
+    struct list_elem elem;              /* Element in a free list. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Percentage of each pool that is never lent to the other pool.
+   Controlled by kernel command-line option "-poolreserve=PCT". */
+unsigned palloc_lend_reserve = 25;
+
+/* If true (default), zero user pages in advance while idle.
+   Controlled by kernel command-line option "-noprezero". */
+bool palloc_prezero = true;
+
+/* Prezeroed user pages, as indexes into the user pool.
+   Protected by disabling interrupts. */
+#define PREZERO_MAX 64                  /* Most pages to keep zeroed. */
+#define PREZERO_BATCH 4                 /* Pages to zero per idle run. */
+static size_t prezeroed[PREZERO_MAX];
+static size_t prezeroed_cnt;
+static struct idle_work prezero_work;
+
+/* Gets lent kernel pages back; see reclaim_lent(). */
+static struct work reclaim_work;
+
+/* Prezeroing statistics. */
+static unsigned long long prezero_hits;   /* Requests served prezeroed. */
+static unsigned long long prezero_misses; /* Zeroed on demand instead. */
+static unsigned long long prezero_pages;  /* Pages zeroed while idle. */
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
-static bool page_from_pool (const struct pool *, void *page);
+static bool page_from_pool (const struct pool *, const void *page);
+static uint8_t *share_cnt (const void *page);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static size_t lend_reserve (const struct pool *);
+static size_t borrow (struct pool *lender, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void print_pool_stats (const struct pool *);
+static size_t take_prezeroed (void);
+static void prezero (void *aux);
+static void reclaim_lent (void *aux);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -60,27 +172,60 @@ palloc_init (size_t user_page_limit)
   init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
   init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
              user_pages, "user pool");
+
+  if (palloc_prezero)
+    idle_work_add (&prezero_work, prezero, NULL, 1);
+  work_init (&reclaim_work, reclaim_lent, NULL);
 }
 
-/* Obtains and returns a group of PAGE_CNT contiguous free pages.
+/* Obtains and returns a group of PAGE_CNT contiguous free pages,
+   charging them to TAG.
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
    FLAGS, in which case the kernel panics. */
 void *
-palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
+palloc_get_multiple_tagged (enum palloc_flags flags, size_t page_cnt,
+                            const char *tag)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  struct pool *lender = flags & PAL_USER ? &kernel_pool : &user_pool;
+  bool single_user = page_cnt == 1 && pool == &user_pool;
+  bool zeroed = false;
   void *pages;
   size_t page_idx;
+  enum intr_level old_level;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  old_level = intr_disable ();
+  page_idx = BITMAP_ERROR;
+  if (single_user && (flags & PAL_ZERO))
+    page_idx = take_prezeroed ();
+  if (page_idx != BITMAP_ERROR)
+    zeroed = true;
+  else
+    page_idx = buddy_alloc (pool, page_cnt);
+  if (page_idx == BITMAP_ERROR && single_user)
+    page_idx = take_prezeroed ();
+  if (page_idx == BITMAP_ERROR)
+    {
+      page_idx = borrow (lender, page_cnt);
+      if (page_idx != BITMAP_ERROR)
+        pool = lender;
+      else
+        pool->failures++;
+    }
+
+  /* Pages are only lent from the kernel pool once the user pool
+     runs dry, which takes user processes, so system_wq is
+     running by then. */
+  if (!(flags & PAL_USER) && kernel_pool.lent_cnt > 0
+      && kernel_pool.free_cnt <= lend_reserve (&kernel_pool))
+    work_queue (&system_wq, &reclaim_work);
+  intr_set_level (old_level);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -89,8 +234,28 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
-        memset (pages, 0, PGSIZE * page_cnt);
+      if (pool->page_tag != NULL)
+        {
+          int id = memtag_lookup (tag, MEMTAG_PALLOC);
+          size_t i;
+
+          for (i = 0; i < page_cnt; i++)
+            {
+              pool->page_tag[page_idx + i] = id;
+              memtag_alloc (id, PGSIZE);
+            }
+        }
+      if ((flags & PAL_ZERO) && !zeroed)
+        {
+          size_t i;
+
+          for (i = 0; i < page_cnt; i++)
+            page_zero ((uint8_t *) pages + PGSIZE * i);
+          if (single_user)
+            prezero_misses++;
+        }
+      else if (zeroed)
+        prezero_hits++;
     }
   else 
     {
@@ -101,32 +266,43 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   return pages;
 }
 
-void * get_page(enum palloc_flags flags)
+void * get_page_tagged(enum palloc_flags flags, const char *tag)
 {
-	void *kpage = palloc_get_page(flags);
+	void *kpage = palloc_get_page_tagged(flags, tag);
+#ifdef USERPROG
+	/* 
+	If user processes are holding pages borrowed from the kernel pool, evict them one at a time until a kernel page 
+	comes free. get_page() is only called where the caller holds no allocator locks and could sleep anyway. 
+	*/
+	while(kpage == NULL && !(flags & PAL_USER) && kernel_pool.lent_cnt > 0 && evict_lent_frame())
+	{
+		kernel_pool.reclaims++;
+		kpage = palloc_get_page_tagged(flags, tag);
+	}
 	if(kpage == NULL) 
 	{
 		evict_algorithm();
-		kpage = palloc_get_page(flags);
+		kpage = palloc_get_page_tagged(flags, tag);
 		//if(kpage == NULL) printf ("eviction didn't work!\n");
 		//else printf ("eviction did work!\n");
 		return kpage;
 	}
-	else return kpage;
+#endif
+	return kpage;
 }
 
 
 /* Obtains a single free page and returns its kernel virtual
-   address.
+   address, charging it to TAG.
    If PAL_USER is set, the page is obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the page is filled with zeros.  If no pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
    FLAGS, in which case the kernel panics. */
 void *
-palloc_get_page (enum palloc_flags flags) 
+palloc_get_page_tagged (enum palloc_flags flags, const char *tag) 
 {
-  return palloc_get_multiple (flags, 1);
+  return palloc_get_multiple_tagged (flags, 1, tag);
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -135,6 +311,7 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
@@ -149,50 +326,428 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 
   page_idx = pg_no (pages) - pg_no (pool->base);
 
+  if (pool->page_tag != NULL)
+    {
+      size_t i;
+
+      for (i = 0; i < page_cnt; i++)
+        memtag_free (pool->page_tag[page_idx + i], PGSIZE);
+    }
+
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  old_level = intr_disable ();
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  if (pool->lent_cnt > 0)
+    {
+      pool->lent_cnt -= bitmap_count (pool->lent_map, page_idx, page_cnt,
+                                      true);
+      bitmap_set_multiple (pool->lent_map, page_idx, page_cnt, false);
+    }
+  buddy_free (pool, page_idx, page_cnt);
+  intr_set_level (old_level);
 }
 
-/* Frees the page at PAGE. */
+/* Drops a reference to the page at PAGE, freeing it if that was
+   the last one. */
 void
 palloc_free_page (void *page) 
 {
+  if (page != NULL)
+    {
+      uint8_t *cnt = share_cnt (page);
+      enum intr_level old_level = intr_disable ();
+      bool shared = *cnt > 0;
+
+      if (shared)
+        --*cnt;
+      intr_set_level (old_level);
+      if (shared)
+        return;
+    }
   palloc_free_multiple (page, 1);
 }
 
+/* Adds a reference to PAGE, which must be in use, so that it
+   takes one more palloc_free_page() to free it.  Returns false,
+   without adding a reference, if PAGE already has as many
+   references as can be counted. */
+bool
+palloc_share_page (void *page) 
+{
+  uint8_t *cnt = share_cnt (page);
+  enum intr_level old_level = intr_disable ();
+  bool success = *cnt < UINT8_MAX;
+
+  if (success)
+    ++*cnt;
+  intr_set_level (old_level);
+  return success;
+}
+
+/* Returns true if PAGE has more than one reference. */
+bool
+palloc_page_shared (const void *page) 
+{
+  return *share_cnt (page) > 0;
+}
+
+/* Fills PAGE, which must be page-aligned, with zeros. */
+void
+page_zero (void *page) 
+{
+  size_t words = PGSIZE / sizeof (uint32_t);
+
+  ASSERT (pg_ofs (page) == 0);
+
+  asm volatile ("rep stosl"
+                : "+D" (page), "+c" (words) : "a" (0) : "memory");
+}
+
+/* Copies page SRC to page DST.  Both must be page-aligned. */
+void
+page_copy (void *dst, const void *src) 
+{
+  size_t words = PGSIZE / sizeof (uint32_t);
+
+  ASSERT (pg_ofs (dst) == 0);
+  ASSERT (pg_ofs (src) == 0);
+
+  asm volatile ("rep movsl"
+                : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+}
+
+/* Returns true if PAGE belongs to the kernel pool but is lent to
+   the user pool. */
+bool
+palloc_lent_by_kernel (const void *page) 
+{
+  size_t page_idx;
+
+  if (!page_from_pool (&kernel_pool, page))
+    return false;
+  page_idx = pg_no (page) - pg_no (kernel_pool.base);
+  return bitmap_test (kernel_pool.lent_map, page_idx);
+}
+
+/* Prints fragmentation statistics for both pools. */
+void
+palloc_print_stats (void) 
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  /* We'll put the pool's used_map and lent_map, its free_order
+     and share_cnt arrays, and (if tagging) its page_tag array at
+     its base.  Calculate the space needed for them and subtract
+     it from the pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t tag_size = memtag_enabled ? page_cnt : 0;
+  size_t bm_pages = DIV_ROUND_UP (2 * bm_size + 2 * page_cnt + tag_size,
+                                  PGSIZE);
+  int order;
+
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
-  /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  /* Initialize the pool, with every page in use. */
+  p->name = name;
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  bitmap_set_all (p->used_map, true);
+  p->lent_map = bitmap_create_in_buf (page_cnt, (uint8_t *) base + bm_size,
+                                      bm_size);
+  p->free_order = (uint8_t *) base + 2 * bm_size;
+  memset (p->free_order, 0, page_cnt);
+  p->share_cnt = p->free_order + page_cnt;
+  memset (p->share_cnt, 0, page_cnt);
+  p->page_tag = tag_size > 0 ? p->share_cnt + page_cnt : NULL;
+  for (order = 0; order <= MAX_ORDER; order++)
+    {
+      list_init (&p->free_lists[order]);
+      p->free_blocks[order] = 0;
+    }
   p->base = base + bm_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  p->free_cnt = 0;
+  p->lent_cnt = 0;
+  p->splits = p->merges = p->failures = 0;
+  p->lends = p->reclaims = 0;
+
+  /* Then free all of them, which builds the free lists. */
+  buddy_free (p, 0, page_cnt);
+  p->merges = 0;
 }
 
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
-page_from_pool (const struct pool *pool, void *page) 
+page_from_pool (const struct pool *pool, const void *page) 
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the share count of PAGE, which must be from one of
+   the pools. */
+static uint8_t *
+share_cnt (const void *page) 
+{
+  struct pool *pool;
+
+  if (page_from_pool (&kernel_pool, page))
+    pool = &kernel_pool;
+  else if (page_from_pool (&user_pool, page))
+    pool = &user_pool;
+  else
+    NOT_REACHED ();
+  return &pool->share_cnt[pg_no (page) - pg_no (pool->base)];
+}
+
+/* Returns the free block that starts at page PAGE_IDX in POOL. */
+static struct free_block *
+idx_to_block (const struct pool *pool, size_t page_idx) 
+{
+  return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the block of order ORDER at PAGE_IDX to POOL's free
+   lists. */
+static void
+push_block (struct pool *pool, size_t page_idx, int order) 
+{
+  pool->free_order[page_idx] = order + 1;
+  list_push_front (&pool->free_lists[order],
+                   &idx_to_block (pool, page_idx)->elem);
+  pool->free_blocks[order]++;
+}
+
+/* Removes the block of order ORDER at PAGE_IDX from POOL's free
+   lists. */
+static void
+remove_block (struct pool *pool, size_t page_idx, int order) 
+{
+  ASSERT (pool->free_order[page_idx] == order + 1);
+
+  pool->free_order[page_idx] = 0;
+  list_remove (&idx_to_block (pool, page_idx)->elem);
+  pool->free_blocks[order]--;
+}
+
+/* Frees the single block of 2**ORDER pages at PAGE_IDX in POOL,
+   merging it with its buddy for as long as possible. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order) 
+{
+  while (order < MAX_ORDER)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+      if (buddy_idx + ((size_t) 1 << order) > pool->page_cnt
+          || pool->free_order[buddy_idx] != order + 1)
+        break;
+
+      remove_block (pool, buddy_idx, order);
+      if (buddy_idx < page_idx)
+        page_idx = buddy_idx;
+      order++;
+      pool->merges++;
+    }
+  push_block (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX in POOL, as the
+   largest aligned blocks that they can be split into.
+   Interrupts must be off. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  pool->free_cnt += page_cnt;
+
+  while (page_cnt > 0)
+    {
+      int order = 0;
+      while (order < MAX_ORDER
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL.  Returns the
+   index of the first page, or BITMAP_ERROR if no block is large
+   enough.  Interrupts must be off. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) 
+{
+  int order, want;
+  size_t page_idx, block_cnt;
+
+  /* Find the smallest order that fits PAGE_CNT. */
+  for (want = 0; want <= MAX_ORDER; want++)
+    if (((size_t) 1 << want) >= page_cnt)
+      break;
+
+  /* Find the smallest free block of at least that order. */
+  for (order = want; order <= MAX_ORDER; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order > MAX_ORDER)
+    return BITMAP_ERROR;
+
+  page_idx = pg_no (list_front (&pool->free_lists[order]))
+             - pg_no (pool->base);
+  remove_block (pool, page_idx, order);
+
+  /* Split it down to the order we want, freeing upper halves. */
+  while (order > want)
+    {
+      order--;
+      push_block (pool, page_idx + ((size_t) 1 << order), order);
+      pool->splits++;
+    }
+
+  /* Give back the pages beyond PAGE_CNT. */
+  block_cnt = (size_t) 1 << order;
+  pool->free_cnt -= block_cnt;
+  bitmap_set_multiple (pool->used_map, page_idx, block_cnt, true);
+  if (block_cnt > page_cnt)
+    buddy_free (pool, page_idx + page_cnt, block_cnt - page_cnt);
+
+  return page_idx;
+}
+
+/* Returns the number of POOL's pages that it never lends. */
+static size_t
+lend_reserve (const struct pool *pool) 
+{
+  return pool->page_cnt * palloc_lend_reserve / 100;
+}
+
+/* Allocates PAGE_CNT pages from LENDER on behalf of the other
+   pool, if LENDER can spare them and still keep its reserve.
+   Returns the index of the first page in LENDER, or BITMAP_ERROR.
+   Interrupts must be off. */
+static size_t
+borrow (struct pool *lender, size_t page_cnt) 
+{
+  size_t page_idx;
+
+  if (lender->free_cnt < page_cnt + lend_reserve (lender))
+    return BITMAP_ERROR;
+
+  page_idx = buddy_alloc (lender, page_cnt);
+  if (page_idx != BITMAP_ERROR)
+    {
+      bitmap_set_multiple (lender->lent_map, page_idx, page_cnt, true);
+      lender->lent_cnt += page_cnt;
+      lender->lends++;
+    }
+  return page_idx;
+}
+
+/* Prints POOL's free space and how fragmented it is. */
+static void
+print_pool_stats (const struct pool *pool) 
+{
+  size_t largest = 0;
+  int order;
+
+  for (order = MAX_ORDER; order >= 0; order--)
+    if (pool->free_blocks[order] > 0)
+      {
+        largest = (size_t) 1 << order;
+        break;
+      }
+
+  printf ("Palloc %s: %zu of %zu pages free, largest free block "
+          "%zu pages, %zu%% fragmented\n",
+          pool->name, pool->free_cnt, pool->page_cnt, largest,
+          pool->free_cnt > 0
+          ? 100 - largest * 100 / pool->free_cnt : (size_t) 0);
+  printf ("  free blocks by order:");
+  for (order = 0; order <= MAX_ORDER; order++)
+    printf (" %zu", pool->free_blocks[order]);
+  printf ("\n  %llu splits, %llu merges, %llu failed requests\n",
+          pool->splits, pool->merges, pool->failures);
+  printf ("  %zu pages lent to other pool, %llu loans, "
+          "%llu frames reclaimed\n",
+          pool->lent_cnt, pool->lends, pool->reclaims);
+  if (pool == &user_pool && palloc_prezero)
+    printf ("  %zu pages prezeroed, %llu zeroed while idle, "
+            "%llu requests served prezeroed, %llu zeroed on demand\n",
+            prezeroed_cnt, prezero_pages, prezero_hits, prezero_misses);
+}
+
+/* Takes a page from the prezeroed set.  Returns its index in the
+   user pool, or BITMAP_ERROR if there are none.  Interrupts must
+   be off. */
+static size_t
+take_prezeroed (void) 
+{
+  return prezeroed_cnt > 0 ? prezeroed[--prezeroed_cnt] : BITMAP_ERROR;
+}
+
+/* Idle work that zeroes a few free user pages and sets them
+   aside, until PREZERO_MAX are set aside.  Leaves pages alone
+   while the user pool is short of free pages. */
+static void
+prezero (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < PREZERO_BATCH; i++)
+    {
+      enum intr_level old_level = intr_disable ();
+      size_t page_idx = BITMAP_ERROR;
+
+      if (prezeroed_cnt < PREZERO_MAX && user_pool.free_cnt > PREZERO_MAX)
+        page_idx = buddy_alloc (&user_pool, 1);
+      intr_set_level (old_level);
+      if (page_idx == BITMAP_ERROR)
+        break;
+
+      page_zero (user_pool.base + PGSIZE * page_idx);
+      prezero_pages++;
+
+      /* Someone may have filled the set while we were zeroing. */
+      old_level = intr_disable ();
+      if (prezeroed_cnt < PREZERO_MAX)
+        prezeroed[prezeroed_cnt++] = page_idx;
+      else
+        buddy_free (&user_pool, page_idx, 1);
+      intr_set_level (old_level);
+    }
+}
+
+/* Evicts user frames borrowed from the kernel pool until the
+   kernel pool is back above its reserve or has nothing left on
+   loan.  Runs on system_wq, where it may sleep and holds no
+   allocator locks. */
+static void
+reclaim_lent (void *aux UNUSED) 
+{
+#ifdef USERPROG
+  while (kernel_pool.lent_cnt > 0
+         && kernel_pool.free_cnt <= lend_reserve (&kernel_pool)
+         && evict_lent_frame ())
+    kernel_pool.reclaims++;
+#endif
+}
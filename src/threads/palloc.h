@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /* How to allocate pages. */
@@ -11,11 +12,33 @@ enum palloc_flags
     PAL_USER = 004              /* User page. */
   };
 
+/* Percentage of each pool that is never lent to the other pool.
+   Controlled by kernel command-line option "-poolreserve=PCT". */
+extern unsigned palloc_lend_reserve;
+
+/* If true (default), zero user pages in advance while idle.
+   Controlled by kernel command-line option "-noprezero". */
+extern bool palloc_prezero;
+
 void palloc_init (size_t user_page_limit);
-void *palloc_get_page (enum palloc_flags);
-void * get_page(enum palloc_flags flags);
-void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_page_tagged (enum palloc_flags, const char *tag);
+void *get_page_tagged (enum palloc_flags, const char *tag);
+void *palloc_get_multiple_tagged (enum palloc_flags, size_t page_cnt,
+                                  const char *tag);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+bool palloc_lent_by_kernel (const void *);
+bool palloc_share_page (void *);
+bool palloc_page_shared (const void *);
+void page_zero (void *);
+void page_copy (void *, const void *);
+void palloc_print_stats (void);
+
+/* Pages are charged to the calling source file when memory
+   tagging is enabled.  See threads/memtag.c. */
+#define palloc_get_page(FLAGS) palloc_get_page_tagged (FLAGS, __FILE__)
+#define get_page(FLAGS) get_page_tagged (FLAGS, __FILE__)
+#define palloc_get_multiple(FLAGS, PAGE_CNT) \
+        palloc_get_multiple_tagged (FLAGS, PAGE_CNT, __FILE__)
 
 #endif /* threads/palloc.h */
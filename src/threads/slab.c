@@ -0,0 +1,243 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator for fixed-size kernel objects.
+
+   malloc() rounds every request up to a power of 2, so a 24-byte
+   object occupies 32 bytes and a 36-byte object 64.  It also
+   serializes every allocation of a given size class behind one
+   descriptor lock, no matter what the objects are for.
+
+   A slab cache instead hands out objects of exactly one size,
+   rounded up only to SLAB_ALIGN bytes.  Each cache draws whole
+   pages, called "slabs", from the page allocator and carves
+   them into objects.  A slab header at the start of each page
+   holds a singly linked list of the slab's free objects.  Slabs
+   with free objects sit on the cache's partial list, so
+   allocation and freeing are both O(1), and each cache has its
+   own lock.
+
+   When a slab becomes entirely free it is returned to the page
+   allocator, unless it is the only slab with free objects in
+   its cache: keeping one around avoids paying for a page on
+   every allocation when a single object is allocated and freed
+   over and over. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Objects are aligned to this many bytes. */
+#define SLAB_ALIGN 8
+
+/* Slab header, at the beginning of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's partial or full list. */
+    size_t free_cnt;            /* Number of free objects. */
+    void *free;                 /* First free object. */
+  };
+
+/* Space taken by the slab header, rounded up to SLAB_ALIGN. */
+#define SLAB_HEADER_SIZE ROUND_UP (sizeof (struct slab), SLAB_ALIGN)
+
+/* All slab caches, for statistics. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+static struct slab *slab_create (struct slab_cache *);
+static struct slab *obj_to_slab (struct slab_cache *, void *);
+
+/* Initializes CACHE to hand out objects of SIZE bytes.  NAME is
+   used only for statistics and must remain valid as long as the
+   kernel runs. */
+void
+slab_cache_init (struct slab_cache *cache, const char *name, size_t size) 
+{
+  enum intr_level old_level;
+
+  ASSERT (cache != NULL);
+  ASSERT (name != NULL);
+  ASSERT (size > 0);
+
+  cache->name = name;
+  cache->obj_size = ROUND_UP (size < sizeof (void *) ? sizeof (void *) : size,
+                              SLAB_ALIGN);
+  ASSERT (cache->obj_size <= PGSIZE - SLAB_HEADER_SIZE);
+  cache->objs_per_slab = (PGSIZE - SLAB_HEADER_SIZE) / cache->obj_size;
+  list_init (&cache->partial);
+  list_init (&cache->full);
+  lock_init (&cache->lock);
+  lock_set_name (&cache->lock, name);
+  cache->slab_cnt = 0;
+  cache->active_cnt = cache->max_active_cnt = 0;
+  cache->alloc_cnt = cache->free_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_caches, &cache->allelem);
+  intr_set_level (old_level);
+}
+
+/* Obtains and returns a new object from CACHE.  Returns a null
+   pointer if memory is not available. */
+void *
+slab_alloc (struct slab_cache *cache) 
+{
+  struct slab *s;
+  void *obj;
+
+  ASSERT (cache != NULL);
+
+  lock_acquire (&cache->lock);
+  if (list_empty (&cache->partial))
+    {
+      s = slab_create (cache);
+      if (s == NULL)
+        {
+          lock_release (&cache->lock);
+          return NULL;
+        }
+      list_push_front (&cache->partial, &s->elem);
+    }
+  else
+    s = list_entry (list_front (&cache->partial), struct slab, elem);
+
+  /* Take the first free object. */
+  obj = s->free;
+  s->free = *(void **) obj;
+  if (--s->free_cnt == 0)
+    {
+      list_remove (&s->elem);
+      list_push_back (&cache->full, &s->elem);
+    }
+
+  cache->alloc_cnt++;
+  if (++cache->active_cnt > cache->max_active_cnt)
+    cache->max_active_cnt = cache->active_cnt;
+  lock_release (&cache->lock);
+
+  return obj;
+}
+
+/* Like slab_alloc(), but zeros the object. */
+void *
+slab_zalloc (struct slab_cache *cache) 
+{
+  void *obj = slab_alloc (cache);
+  if (obj != NULL)
+    memset (obj, 0, cache->obj_size);
+  return obj;
+}
+
+/* Returns OBJ, which must have been obtained from CACHE, to
+   CACHE.  A null OBJ is ignored. */
+void
+slab_free (struct slab_cache *cache, void *obj) 
+{
+  struct slab *s;
+
+  ASSERT (cache != NULL);
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (cache, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs. */
+  memset (obj, 0xcc, cache->obj_size);
+#endif
+
+  lock_acquire (&cache->lock);
+  *(void **) obj = s->free;
+  s->free = obj;
+  if (s->free_cnt++ == 0)
+    {
+      /* Slab was full; it has room again. */
+      list_remove (&s->elem);
+      list_push_front (&cache->partial, &s->elem);
+    }
+  else if (s->free_cnt == cache->objs_per_slab
+           && list_front (&cache->partial) != list_back (&cache->partial))
+    {
+      /* Slab is entirely free and there are others with room. */
+      list_remove (&s->elem);
+      cache->slab_cnt--;
+      palloc_free_page (s);
+    }
+  cache->free_cnt++;
+  cache->active_cnt--;
+  lock_release (&cache->lock);
+}
+
+/* Prints statistics for each slab cache. */
+void
+slab_print_stats (void) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct slab_cache *c = list_entry (e, struct slab_cache, allelem);
+      printf ("Slab %s: %zu-byte objects, %zu active (%zu max), "
+              "%zu slabs, %llu allocs, %llu frees\n",
+              c->name, c->obj_size, c->active_cnt, c->max_active_cnt,
+              c->slab_cnt, c->alloc_cnt, c->free_cnt);
+    }
+}
+
+/* Allocates a new slab for CACHE and threads all of its objects
+   onto its free list.  Returns the slab, or a null pointer if
+   no page is available.  CACHE's lock must be held. */
+static struct slab *
+slab_create (struct slab_cache *cache) 
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&cache->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = cache;
+  s->free_cnt = cache->objs_per_slab;
+  s->free = NULL;
+  obj = ((uint8_t *) s + SLAB_HEADER_SIZE
+         + cache->obj_size * cache->objs_per_slab);
+  for (i = 0; i < cache->objs_per_slab; i++)
+    {
+      obj -= cache->obj_size;
+      *(void **) obj = s->free;
+      s->free = obj;
+    }
+  cache->slab_cnt++;
+
+  return s;
+}
+
+/* Returns the slab that OBJ, an object from CACHE, is inside. */
+static struct slab *
+obj_to_slab (struct slab_cache *cache, void *obj) 
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid and belongs to CACHE. */
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == cache);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT ((pg_ofs (obj) - SLAB_HEADER_SIZE) % cache->obj_size == 0);
+
+  return s;
+}
@@ -0,0 +1,33 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* A cache of fixed-size objects.  See slab.c for details. */
+struct slab_cache
+  {
+    const char *name;           /* Name (for statistics). */
+    size_t obj_size;            /* Size of each object in bytes. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    struct list partial;        /* Slabs with at least one free object. */
+    struct list full;           /* Slabs with no free objects. */
+    struct lock lock;           /* Protects the members above. */
+    struct list_elem allelem;   /* Element in list of all caches. */
+
+    /* Statistics. */
+    size_t slab_cnt;            /* Slabs currently allocated. */
+    size_t active_cnt;          /* Objects currently allocated. */
+    size_t max_active_cnt;      /* High-water mark of ACTIVE_CNT. */
+    unsigned long long alloc_cnt;       /* Total allocations. */
+    unsigned long long free_cnt;        /* Total frees. */
+  };
+
+void slab_cache_init (struct slab_cache *, const char *name, size_t size);
+void *slab_alloc (struct slab_cache *) __attribute__ ((malloc));
+void *slab_zalloc (struct slab_cache *) __attribute__ ((malloc));
+void slab_free (struct slab_cache *, void *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -28,9 +28,21 @@
 
 #include "threads/synch.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* If true, named synchronization objects gather statistics.
+   Controlled by kernel command-line option "-lockprof". */
+bool synch_profiling;
+
+/* Profiles, one per distinct name. */
+#define PROFILE_CNT 64
+static struct synch_profile profiles[PROFILE_CNT];
+
+static struct synch_profile *profile_lookup (const char *name);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -48,6 +60,18 @@ sema_init (struct semaphore *sema, unsigned value)
 
   sema->value = value;
   list_init (&sema->waiters);
+  sema->profile = NULL;
+}
+
+/* Names SEMA for the contention profiler.  NAME must remain
+   valid as long as the kernel runs, which in practice means it
+   must be a string literal. */
+void
+sema_set_name (struct semaphore *sema, const char *name) 
+{
+  ASSERT (sema != NULL);
+
+  sema->profile = profile_lookup (name);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -60,18 +84,32 @@ sema_init (struct semaphore *sema, unsigned value)
 void
 sema_down (struct semaphore *sema) 
 {
+  struct synch_profile *p = NULL;
   enum intr_level old_level;
+  int64_t start = 0;
 
   ASSERT (sema != NULL);
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
+  if (synch_profiling && sema->profile != NULL)
+    {
+      sema->profile->acquires++;
+      if (sema->value == 0)
+        {
+          p = sema->profile;
+          p->contended++;
+          start = timer_ticks ();
+        }
+    }
   while (sema->value == 0) 
     {
       list_push_back (&sema->waiters, &thread_current ()->elem);
       thread_block ();
     }
   sema->value--;
+  if (p != NULL)
+    p->wait_ticks += timer_ticks () - start;
   intr_set_level (old_level);
 }
 
@@ -93,6 +131,8 @@ sema_try_down (struct semaphore *sema)
     {
       sema->value--;
       success = true; 
+      if (synch_profiling && sema->profile != NULL)
+        sema->profile->acquires++;
     }
   else
     success = false;
@@ -179,6 +219,17 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+  lock->acquire_tick = 0;
+}
+
+/* Names LOCK for the contention profiler.  NAME must remain
+   valid as long as the kernel runs. */
+void
+lock_set_name (struct lock *lock, const char *name)
+{
+  ASSERT (lock != NULL);
+
+  sema_set_name (&lock->semaphore, name);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -198,6 +249,8 @@ lock_acquire (struct lock *lock)
 
   sema_down (&lock->semaphore);
   lock->holder = thread_current ();
+  if (synch_profiling && lock->semaphore.profile != NULL)
+    lock->acquire_tick = timer_ticks ();
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -216,7 +269,11 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      if (synch_profiling && lock->semaphore.profile != NULL)
+        lock->acquire_tick = timer_ticks ();
+    }
   return success;
 }
 
@@ -231,6 +288,13 @@ lock_release (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  if (synch_profiling && lock->semaphore.profile != NULL)
+    {
+      struct synch_profile *p = lock->semaphore.profile;
+      int64_t hold = timer_ticks () - lock->acquire_tick;
+      if (hold > p->max_hold_ticks)
+        p->max_hold_ticks = hold;
+    }
   lock->holder = NULL;
   sema_up (&lock->semaphore);
 }
@@ -262,6 +326,17 @@ cond_init (struct condition *cond)
   ASSERT (cond != NULL);
 
   list_init (&cond->waiters);
+  cond->profile = NULL;
+}
+
+/* Names COND for the contention profiler.  NAME must remain
+   valid as long as the kernel runs. */
+void
+cond_set_name (struct condition *cond, const char *name)
+{
+  ASSERT (cond != NULL);
+
+  cond->profile = profile_lookup (name);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -297,7 +372,19 @@ cond_wait (struct condition *cond, struct lock *lock)
   sema_init (&waiter.semaphore, 0);
   list_push_back (&cond->waiters, &waiter.elem);
   lock_release (lock);
-  sema_down (&waiter.semaphore);
+  if (synch_profiling && cond->profile != NULL)
+    {
+      struct synch_profile *p = cond->profile;
+      int64_t start = timer_ticks ();
+
+      /* Waiting on a condition always sleeps. */
+      p->acquires++;
+      p->contended++;
+      sema_down (&waiter.semaphore);
+      p->wait_ticks += timer_ticks () - start;
+    }
+  else
+    sema_down (&waiter.semaphore);
   lock_acquire (lock);
 }
 
@@ -336,3 +423,379 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes wait queue WQ. */
+void
+wait_queue_init (struct wait_queue *wq)
+{
+  ASSERT (wq != NULL);
+
+  list_init (&wq->waiters);
+  wq->profile = NULL;
+}
+
+/* Names WQ for the contention profiler.  NAME must remain valid
+   as long as the kernel runs. */
+void
+wait_queue_set_name (struct wait_queue *wq, const char *name)
+{
+  ASSERT (wq != NULL);
+
+  wq->profile = profile_lookup (name);
+}
+
+/* Atomically releases LOCK and sleeps on WQ until woken by
+   wait_queue_wake_one() or wait_queue_wake_all(), then
+   reacquires LOCK before returning.  LOCK must be held before
+   calling this function.  As with cond_wait(), the caller must
+   recheck its condition after the wait completes.
+
+   Interrupts stay off from the moment the current thread joins
+   WQ until it blocks, so a wake-up issued by a thread that
+   acquires LOCK after we release it cannot be lost.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+wait_queue_wait (struct wait_queue *wq, struct lock *lock)
+{
+  struct synch_profile *p = NULL;
+  enum intr_level old_level;
+  int64_t start = 0;
+
+  ASSERT (wq != NULL);
+  ASSERT (lock != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (lock_held_by_current_thread (lock));
+
+  if (synch_profiling && wq->profile != NULL)
+    {
+      p = wq->profile;
+      p->acquires++;
+      p->contended++;
+      start = timer_ticks ();
+    }
+
+  old_level = intr_disable ();
+  list_push_back (&wq->waiters, &thread_current ()->elem);
+  lock_release (lock);
+  thread_block ();
+  intr_set_level (old_level);
+
+  if (p != NULL)
+    p->wait_ticks += timer_ticks () - start;
+  lock_acquire (lock);
+}
+
+/* Wakes up the thread that has waited longest on WQ, if any.
+
+   This function does not sleep, so it may be called within an
+   interrupt handler. */
+void
+wait_queue_wake_one (struct wait_queue *wq)
+{
+  enum intr_level old_level;
+
+  ASSERT (wq != NULL);
+
+  old_level = intr_disable ();
+  if (!list_empty (&wq->waiters))
+    thread_unblock (list_entry (list_pop_front (&wq->waiters),
+                                struct thread, elem));
+  intr_set_level (old_level);
+}
+
+/* Wakes up every thread waiting on WQ.
+
+   This function does not sleep, so it may be called within an
+   interrupt handler. */
+void
+wait_queue_wake_all (struct wait_queue *wq)
+{
+  enum intr_level old_level;
+
+  ASSERT (wq != NULL);
+
+  old_level = intr_disable ();
+  while (!list_empty (&wq->waiters))
+    thread_unblock (list_entry (list_pop_front (&wq->waiters),
+                                struct thread, elem));
+  intr_set_level (old_level);
+}
+
+/* Returns the profile for NAME, creating it if necessary.
+   Returns a null pointer if NAME is null or if the profile
+   table is full, in which case the object goes unprofiled. */
+static struct synch_profile *
+profile_lookup (const char *name)
+{
+  struct synch_profile *p;
+  enum intr_level old_level;
+
+  if (name == NULL)
+    return NULL;
+
+  old_level = intr_disable ();
+  for (p = profiles; p < profiles + PROFILE_CNT; p++)
+    if (p->name == NULL)
+      {
+        p->name = name;
+        break;
+      }
+    else if (!strcmp (p->name, name))
+      break;
+  intr_set_level (old_level);
+
+  return p < profiles + PROFILE_CNT ? p : NULL;
+}
+
+/* Orders profiles by decreasing wait ticks, then by decreasing
+   number of contended acquisitions. */
+static int
+compare_profiles (const void *a_, const void *b_)
+{
+  const struct synch_profile *a = *(const struct synch_profile **) a_;
+  const struct synch_profile *b = *(const struct synch_profile **) b_;
+
+  if (a->wait_ticks != b->wait_ticks)
+    return a->wait_ticks > b->wait_ticks ? -1 : 1;
+  if (a->contended != b->contended)
+    return a->contended > b->contended ? -1 : 1;
+  return strcmp (a->name, b->name);
+}
+
+/* Prints the contention profile, hottest objects first.  Does
+   nothing unless profiling is enabled. */
+void
+synch_print_profile (void)
+{
+  struct synch_profile *sorted[PROFILE_CNT];
+  size_t cnt, i;
+
+  if (!synch_profiling)
+    return;
+
+  /* Stop profiling, so that the console lock taken by printf()
+     does not change the numbers while we print them. */
+  synch_profiling = false;
+
+  cnt = 0;
+  for (i = 0; i < PROFILE_CNT && profiles[i].name != NULL; i++)
+    if (profiles[i].acquires > 0)
+      sorted[cnt++] = &profiles[i];
+  qsort (sorted, cnt, sizeof *sorted, compare_profiles);
+
+  printf ("Lock profile: %zu active objects\n", cnt);
+  printf ("  %-20s %10s %10s %10s %10s\n",
+          "name", "acquires", "contended", "wait", "max hold");
+  for (i = 0; i < cnt; i++)
+    {
+      struct synch_profile *p = sorted[i];
+      printf ("  %-20s %10llu %10llu %10lld %10lld\n", p->name,
+              p->acquires, p->contended, p->wait_ticks, p->max_hold_ticks);
+    }
+}
+
+/* Initializes reader-writer lock RW. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  cond_init (&rw->readers_ok);
+  cond_init (&rw->writers_ok);
+  rw->readers = 0;
+  rw->writer = NULL;
+  rw->waiting_readers = 0;
+  rw->waiting_writers = 0;
+  rw->write_gen = 0;
+  rw->read_acquires = rw->read_contended = 0;
+  rw->write_acquires = rw->write_contended = 0;
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it
+   and, unless this reader was already waiting when the last
+   writer released RW, no writer is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  unsigned gen;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != thread_current ());
+
+  lock_acquire (&rw->lock);
+  gen = rw->write_gen;
+  if (rw->writer != NULL || rw->waiting_writers > 0)
+    {
+      rw->read_contended++;
+      rw->waiting_readers++;
+      while (rw->writer != NULL
+             || (rw->waiting_writers > 0 && gen == rw->write_gen))
+        cond_wait (&rw->readers_ok, &rw->lock);
+      rw->waiting_readers--;
+    }
+  rw->readers++;
+  rw->read_acquires++;
+  lock_release (&rw->lock);
+}
+
+/* Releases a read hold on RW.  The last reader out lets one
+   waiting writer in. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->readers > 0);
+  if (--rw->readers == 0 && rw->waiting_writers > 0)
+    cond_signal (&rw->writers_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until no reader or writer
+   holds it.  RW must not already be held by the current thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  if (rw->writer != NULL || rw->readers > 0)
+    {
+      rw->write_contended++;
+      rw->waiting_writers++;
+      while (rw->writer != NULL || rw->readers > 0)
+        cond_wait (&rw->writers_ok, &rw->lock);
+      rw->waiting_writers--;
+    }
+  rw->writer = thread_current ();
+  rw->write_acquires++;
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which must be held for writing by the current
+   thread.  Readers that queued up during the write are admitted
+   first, as a batch; otherwise the next writer gets its turn. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  rw->writer = NULL;
+  rw->write_gen++;
+  if (rw->waiting_readers > 0)
+    cond_broadcast (&rw->readers_ok, &rw->lock);
+  else if (rw->waiting_writers > 0)
+    cond_signal (&rw->writers_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise.  Read holds are not tracked per thread. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+/* Prints RW's contention statistics, labeled with NAME. */
+void
+rwlock_print_stats (const struct rwlock *rw, const char *name)
+{
+  printf ("%s: %llu reads (%llu contended), %llu writes (%llu contended)\n",
+          name, rw->read_acquires, rw->read_contended,
+          rw->write_acquires, rw->write_contended);
+}
+
+/* Initializes sequence lock SL. */
+void
+seqlock_init (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+
+  sl->sequence = 0;
+  sl->writes = 0;
+  sl->read_retries = 0;
+}
+
+/* Starts a read-side critical section on SL and returns the
+   sequence number to pass to seqlock_read_retry().
+
+   This function never sleeps, so it may be called within an
+   interrupt handler. */
+unsigned
+seqlock_read_begin (const struct seqlock *sl)
+{
+  unsigned seq;
+
+  ASSERT (sl != NULL);
+
+  seq = sl->sequence;
+  barrier ();
+  return seq;
+}
+
+/* Ends a read-side critical section on SL that began with
+   sequence number START.  Returns true if a writer was active
+   during the read, in which case the data read must be
+   discarded and the read repeated. */
+bool
+seqlock_read_retry (struct seqlock *sl, unsigned start)
+{
+  ASSERT (sl != NULL);
+
+  barrier ();
+  if ((start & 1) == 0 && sl->sequence == start)
+    return false;
+
+  sl->read_retries++;
+  return true;
+}
+
+/* Starts a write-side critical section on SL.  Writers must be
+   serialized by the caller. */
+void
+seqlock_write_begin (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+  ASSERT ((sl->sequence & 1) == 0);
+
+  sl->sequence++;
+  barrier ();
+}
+
+/* Ends a write-side critical section on SL. */
+void
+seqlock_write_end (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+  ASSERT ((sl->sequence & 1) == 1);
+
+  barrier ();
+  sl->sequence++;
+  sl->writes++;
+}
+
+/* Prints SL's contention statistics, labeled with NAME. */
+void
+seqlock_print_stats (const struct seqlock *sl, const char *name)
+{
+  printf ("%s: %llu writes, %llu read retries\n",
+          name, sl->writes, sl->read_retries);
+}
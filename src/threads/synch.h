@@ -3,15 +3,38 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/* Contention profile.  Every named semaphore, lock, or
+   condition variable with the same name shares one profile, so
+   that, for example, the status_change queue of every thread is
+   reported as a single line.  Statistics are only gathered when
+   profiling is enabled with the "-lockprof" kernel option. */
+struct synch_profile
+  {
+    const char *name;                   /* Name, or null if slot unused. */
+    unsigned long long acquires;        /* Acquisitions or waits. */
+    unsigned long long contended;       /* Acquisitions that had to sleep. */
+    int64_t wait_ticks;                 /* Total ticks spent sleeping. */
+    int64_t max_hold_ticks;             /* Longest hold (locks only). */
+  };
+
+/* If true, named synchronization objects gather statistics.
+   Controlled by kernel command-line option "-lockprof". */
+extern bool synch_profiling;
+
+void synch_print_profile (void);
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
     struct list waiters;        /* List of waiting threads. */
+    struct synch_profile *profile;      /* Profile, if named. */
   };
 
 void sema_init (struct semaphore *, unsigned value);
+void sema_set_name (struct semaphore *, const char *name);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
@@ -22,9 +45,11 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    int64_t acquire_tick;       /* When HOLDER acquired it, if profiled. */
   };
 
 void lock_init (struct lock *);
+void lock_set_name (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
@@ -34,13 +59,99 @@ bool lock_held_by_current_thread (const struct lock *);
 struct condition 
   {
     struct list waiters;        /* List of waiting threads. */
+    struct synch_profile *profile;      /* Profile, if named. */
   };
 
 void cond_init (struct condition *);
+void cond_set_name (struct condition *, const char *name);
 void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Wait queue.
+
+   Like a condition variable, but waiting threads are queued
+   directly through their `elem' member instead of through a
+   per-waiter semaphore, so a wake-up is a single
+   thread_unblock() and wait_queue_wake_all() wakes every waiter
+   in one pass with interrupts disabled. */
+struct wait_queue
+  {
+    struct list waiters;        /* List of waiting threads. */
+    struct synch_profile *profile;      /* Profile, if named. */
+  };
+
+void wait_queue_init (struct wait_queue *);
+void wait_queue_set_name (struct wait_queue *, const char *name);
+void wait_queue_wait (struct wait_queue *, struct lock *);
+void wait_queue_wake_one (struct wait_queue *);
+void wait_queue_wake_all (struct wait_queue *);
+
+/* Reader-writer lock.
+
+   Any number of readers may hold the lock at once, or a single
+   writer.  Writers are preferred: once a writer is waiting, newly
+   arriving readers queue behind it.  To keep readers from
+   starving, readers that were already waiting when a writer
+   releases the lock are all admitted before the next writer. */
+struct rwlock
+  {
+    struct lock lock;               /* Protects the members below. */
+    struct condition readers_ok;    /* Signaled when readers may enter. */
+    struct condition writers_ok;    /* Signaled when a writer may enter. */
+    unsigned readers;               /* Number of readers holding the lock. */
+    struct thread *writer;          /* Writer holding the lock, if any. */
+    unsigned waiting_readers;       /* Number of blocked readers. */
+    unsigned waiting_writers;       /* Number of blocked writers. */
+    unsigned write_gen;             /* Incremented on each write release. */
+
+    /* Contention statistics. */
+    unsigned long long read_acquires;   /* Read acquisitions. */
+    unsigned long long read_contended;  /* Read acquisitions that blocked. */
+    unsigned long long write_acquires;  /* Write acquisitions. */
+    unsigned long long write_contended; /* Write acquisitions that blocked. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+void rwlock_print_stats (const struct rwlock *, const char *name);
+
+/* Sequence lock.
+
+   For tiny, frequently read fields such as tick counters.
+   Readers never block: they sample the sequence number, read
+   the protected data, and retry if a writer intervened.
+   Writers must already be serialized against each other, for
+   example by running with interrupts off or under a lock.
+   Typical use:
+
+        unsigned seq;
+        do
+          {
+            seq = seqlock_read_begin (&sl);
+            value = protected_value;
+          }
+        while (seqlock_read_retry (&sl, seq)); */
+struct seqlock
+  {
+    unsigned sequence;              /* Odd while a write is in progress. */
+
+    /* Contention statistics. */
+    unsigned long long writes;        /* Completed writes. */
+    unsigned long long read_retries;  /* Reads that had to be retried. */
+  };
+
+void seqlock_init (struct seqlock *);
+unsigned seqlock_read_begin (const struct seqlock *);
+bool seqlock_read_retry (struct seqlock *, unsigned start);
+void seqlock_write_begin (struct seqlock *);
+void seqlock_write_end (struct seqlock *);
+void seqlock_print_stats (const struct seqlock *, const char *name);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
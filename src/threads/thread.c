@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
+#include "threads/idle.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
@@ -12,7 +13,6 @@
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
-#include "threads/malloc.h"
 #include "devices/block.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -93,10 +93,13 @@ thread_init (void)
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
+  lock_set_name (&tid_lock, "tid");
   list_init (&ready_list);
   list_init (&all_list);
+#ifdef USERPROG
   list_init (&frame_table);
   list_init (&swap_table);
+#endif
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -208,17 +211,7 @@ thread_create (const char *name, int priority,
   sf = alloc_frame (t, sizeof *sf);
   sf->eip = switch_entry;
   sf->ebp = 0;
-  
-	/* pushes the thread to child_list of the running thread. */
-	t->myself	=	(struct child *)malloc(sizeof (struct child));
-	t->myself->parent	=	running_thread();
-	t->myself->tid		=	tid;
-	t->myself->state	=	PROCESS_INITIALIZING;
-	//printf("tid created %d\n",tid);
-	//printf("parent tid %d\n",t->myself->parent->tid);
-	list_push_back(&running_thread()->child_list,&t->myself->elem);
-	
-  
+
   intr_set_level (old_level);
   
 
@@ -422,19 +415,9 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
-      /* Re-enable interrupts and wait for the next one.
-
-         The `sti' instruction disables interrupts until the
-         completion of the next instruction, so these two
-         instructions are executed atomically.  This atomicity is
-         important; otherwise, an interrupt could be handled
-         between re-enabling interrupts and waiting for the next
-         one to occur, wasting as much as one clock tick worth of
-         time.
-
-         See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-         7.11.1 "HLT Instruction". */
-      asm volatile ("sti; hlt" : : : "memory");
+      /* Run deferred work, or else halt until the next
+         interrupt.  See idle.c. */
+      idle_halt ();
     }
 }
 
@@ -486,12 +469,16 @@ init_thread (struct thread *t, const char *name, int priority)
   t->priority = priority;
   t->magic = THREAD_MAGIC;
   
-  /* marks the next available FD ID to be 2. */
-  t->FD_CURRENT	=	2;
-  cond_init (&t->status_change);
-  lock_init (&t->status_change_lock);
+  /* the descriptor table is allocated by the first open(). */
+  t->mapid_next	=	1;
+  wait_queue_init (&t->status_change);
+  wait_queue_set_name (&t->status_change, "status_change");
   list_init (&t->child_list);
-  list_init (&t->file_list);
+  list_init (&t->zombie_list);
+#ifdef USERPROG
+  list_init (&t->frame_list);
+  list_init (&t->swap_list);
+#endif
   list_push_back (&all_list, &t->allelem);
 }
 
@@ -586,6 +573,11 @@ schedule (void)
   ASSERT (cur->status != THREAD_RUNNING);
   ASSERT (is_thread (next));
 
+  /* An interrupt handler may switch away from a halted idle
+     thread before it has a chance to clean up after itself. */
+  if (cur == idle_thread && cur != next)
+    idle_leave ();
+
   if (cur != next)
     prev = switch_threads (cur, next);
   thread_schedule_tail (prev);
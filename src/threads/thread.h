@@ -20,17 +20,9 @@ enum thread_status
 
 typedef int tid_t;
 
-/* 
-every thread has a child element, which is used to indicate the current state of the thread. This gets pushed to the parent's child_list
-*/
-struct child
-{
-	int		exit_code;
-	char 	state;
-	struct thread *parent;
-	tid_t 	tid;
-	struct 	list_elem elem;
-};
+/* A process's record of its own state, shared with its parent
+   (see userprog/process.c). */
+struct child;
 
 /* Thread identifier type.
    You can redefine this to whatever type you like. */
@@ -109,17 +101,23 @@ struct thread
 	bool user_thread;
 	int return_status;
 	
-	struct child *myself;				/* Thread's current state identifier. */
-	struct list child_list;				/* represents the threads list of children. */
+	struct child *myself;				/* Process's current state identifier, or NULL for a kernel thread. */
+	struct list child_list;				/* records of the process's children that are still running. */
+	struct list zombie_list;			/* records of its children that have exited but not been waited for, oldest first. */
 	struct file *my_binary;				/* indicates the thread's binary file. */
-	struct list file_list;				/* represents the list of opened files by the thread. */
-	int 	FD_CURRENT;					/* indicates the thread's next available File Descriptor. */
+	struct file **fd_table;				/* maps each File Descriptor to its open file, or NULL. */
+	struct bitmap *fd_map;				/* marks the File Descriptors in use. */
+	int 	fd_cnt;						/* number of slots in fd_table and fd_map. */
+	int 	mapid_next;					/* the thread's next available mmap id. */
+	void *syscall_esp;					/* user stack pointer at the latest system call. */
+	struct sys_ring *ring;				/* kernel address of the system call ring, or NULL. */
+	void *ring_addr;					/* user address of the system call ring. */
+	bool sysenter_step;					/* true if a single-step trap in sysenter_entry took the caller's trap flag. */
 	
 	/* 
-		lock and condition variable of the thread used by the child to notify the thread of change in its state. 
+		wait queue of the thread used by the child to notify the thread of change in its state. 
 	*/
-	struct lock status_change_lock;	
-	struct condition status_change;
+	struct wait_queue status_change;
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
@@ -128,6 +126,8 @@ struct thread
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
     struct list supp_page_table;
+    struct list frame_list;             /* Frames holding its pages. */
+    struct list swap_list;              /* Swap slots holding its pages. */
 #endif
 
     /* Owned by thread.c. */
@@ -0,0 +1,298 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of worker threads shared by all work queues. */
+#define WORKER_CNT 4
+
+/* All of the lists here are shared with interrupt handlers, so
+   they are protected by disabling interrupts, not by locks. */
+
+/* All work queues. */
+static struct list all_queues = LIST_INITIALIZER (all_queues);
+
+/* Delayed work, ordered by increasing due tick. */
+static struct list delayed = LIST_INITIALIZER (delayed);
+
+/* Worker threads waiting for work. */
+static struct list idle_workers = LIST_INITIALIZER (idle_workers);
+
+/* Queue for work with no particular home. */
+struct workqueue system_wq;
+
+static thread_func worker_thread NO_RETURN;
+static bool wake_worker (void);
+static void enqueue (struct workqueue *, struct work *);
+static bool due_less (const struct list_elem *, const struct list_elem *,
+                      void *aux);
+
+/* Initializes WQ as a work queue named NAME that runs at most
+   MAX_ACTIVE of its work items at a time. */
+void
+workqueue_init (struct workqueue *wq, const char *name, unsigned max_active)
+{
+  enum intr_level old_level;
+
+  ASSERT (wq != NULL);
+  ASSERT (name != NULL);
+  ASSERT (max_active > 0);
+
+  wq->name = name;
+  list_init (&wq->pending);
+  wq->max_active = max_active;
+  wq->active = 0;
+  wq->queued_cnt = wq->run_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_queues, &wq->allelem);
+  intr_set_level (old_level);
+}
+
+/* Initializes system_wq and starts the worker threads.  Work
+   queued on other queues before this point runs once the
+   workers start.  Must be called after thread_start(). */
+void
+workqueue_start (void) 
+{
+  int i;
+
+  workqueue_init (&system_wq, "system", WORKER_CNT);
+
+  for (i = 0; i < WORKER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "kworker %d", i);
+      if (thread_create (name, PRI_DEFAULT, worker_thread, NULL)
+          == TID_ERROR)
+        PANIC ("can't create worker thread");
+    }
+}
+
+/* Initializes WORK to call FUNCTION with AUX. */
+void
+work_init (struct work *work, work_func *function, void *aux)
+{
+  ASSERT (work != NULL);
+  ASSERT (function != NULL);
+
+  work->function = function;
+  work->aux = aux;
+  work->wq = NULL;
+  work->due = 0;
+}
+
+/* Queues WORK to run on WQ as soon as a worker is free.  Returns
+   false, without doing anything, if WORK is already pending or
+   delayed.
+
+   This function may be called from an interrupt handler, in
+   which case a worker that has been woken up gets to run as soon
+   as the handler returns. */
+bool
+work_queue (struct workqueue *wq, struct work *work)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (wq != NULL);
+  ASSERT (work != NULL);
+
+  old_level = intr_disable ();
+  if (work->wq == NULL)
+    {
+      enqueue (wq, work);
+      if (wake_worker () && intr_context ())
+        intr_yield_on_return ();
+      queued = true;
+    }
+  intr_set_level (old_level);
+
+  return queued;
+}
+
+/* Queues WORK to run on WQ once at least TICKS timer ticks have
+   passed.  Returns false, without doing anything, if WORK is
+   already pending or delayed.
+
+   This function may be called from an interrupt handler. */
+bool
+work_queue_delayed (struct workqueue *wq, struct work *work, int64_t ticks)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (wq != NULL);
+  ASSERT (work != NULL);
+
+  if (ticks <= 0)
+    return work_queue (wq, work);
+
+  old_level = intr_disable ();
+  if (work->wq == NULL)
+    {
+      work->wq = wq;
+      work->due = timer_ticks () + ticks;
+      list_insert_ordered (&delayed, &work->elem, due_less, NULL);
+      queued = true;
+    }
+  intr_set_level (old_level);
+
+  return queued;
+}
+
+/* Cancels WORK if it is pending or delayed.  Returns true if it
+   was, false if it was not queued or has already started
+   running. */
+bool
+work_cancel (struct work *work)
+{
+  enum intr_level old_level;
+  bool cancelled = false;
+
+  ASSERT (work != NULL);
+
+  old_level = intr_disable ();
+  if (work->wq != NULL)
+    {
+      list_remove (&work->elem);
+      work->wq = NULL;
+      cancelled = true;
+    }
+  intr_set_level (old_level);
+
+  return cancelled;
+}
+
+/* Returns true if any delayed work is waiting for the timer. */
+bool
+workqueue_timer_pending (void) 
+{
+  return !list_empty (&delayed);
+}
+
+/* Called by the timer interrupt handler with the current tick
+   count NOW.  Moves delayed work that has come due onto its
+   queue. */
+void
+workqueue_tick (int64_t now)
+{
+  bool woke = false;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!list_empty (&delayed))
+    {
+      struct work *w = list_entry (list_front (&delayed), struct work, elem);
+      if (w->due > now)
+        break;
+      list_pop_front (&delayed);
+      enqueue (w->wq, w);
+      woke |= wake_worker ();
+    }
+  if (woke)
+    intr_yield_on_return ();
+}
+
+/* Prints work queue statistics. */
+void
+workqueue_print_stats (void) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_queues); e != list_end (&all_queues);
+       e = list_next (e))
+    {
+      struct workqueue *wq = list_entry (e, struct workqueue, allelem);
+      printf ("Workqueue %s: %lld queued, %lld run\n",
+              wq->name, wq->queued_cnt, wq->run_cnt);
+    }
+}
+
+/* Appends WORK to WQ's pending list.  Interrupts must be off. */
+static void
+enqueue (struct workqueue *wq, struct work *work)
+{
+  work->wq = wq;
+  list_push_back (&wq->pending, &work->elem);
+  wq->queued_cnt++;
+}
+
+/* Wakes up an idle worker, if there is one.  Returns true if
+   successful.  Interrupts must be off. */
+static bool
+wake_worker (void) 
+{
+  if (list_empty (&idle_workers))
+    return false;
+  thread_unblock (list_entry (list_pop_front (&idle_workers),
+                              struct thread, elem));
+  return true;
+}
+
+/* Returns a queue with pending work that is below its
+   concurrency limit, or a null pointer if there is none.
+   Interrupts must be off. */
+static struct workqueue *
+runnable_queue (void) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_queues); e != list_end (&all_queues);
+       e = list_next (e))
+    {
+      struct workqueue *wq = list_entry (e, struct workqueue, allelem);
+      if (!list_empty (&wq->pending) && wq->active < wq->max_active)
+        return wq;
+    }
+  return NULL;
+}
+
+/* Worker thread.  Runs work items from any queue, sleeping when
+   there are none that may run. */
+static void
+worker_thread (void *aux UNUSED) 
+{
+  intr_disable ();
+  for (;;) 
+    {
+      struct workqueue *wq = runnable_queue ();
+      struct work *w;
+
+      if (wq == NULL)
+        {
+          list_push_back (&idle_workers, &thread_current ()->elem);
+          thread_block ();
+          continue;
+        }
+
+      w = list_entry (list_pop_front (&wq->pending), struct work, elem);
+      w->wq = NULL;
+      wq->active++;
+      intr_enable ();
+
+      w->function (w->aux);
+
+      intr_disable ();
+      wq->active--;
+      wq->run_cnt++;
+
+      /* Finishing may have put WQ back under its limit, with
+         work waiting that another idle worker could take. */
+      if (!list_empty (&wq->pending))
+        wake_worker ();
+    }
+}
+
+/* Compares the due ticks of two delayed work items. */
+static bool
+due_less (const struct list_elem *a_, const struct list_elem *b_,
+          void *aux UNUSED)
+{
+  const struct work *a = list_entry (a_, struct work, elem);
+  const struct work *b = list_entry (b_, struct work, elem);
+
+  return a->due < b->due;
+}
@@ -0,0 +1,63 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Kernel work queues.
+
+   A work item is a function call to be made later, in a kernel
+   thread, on behalf of code that cannot or should not make it
+   right away, such as an interrupt handler or a system call on
+   its fast path.  Work items are queued on a work queue and run
+   by a small pool of worker threads shared by all queues.  Each
+   queue limits how many of its items may run at once.
+
+   Work may be queued from kernel threads or from interrupt
+   handlers.  Work functions run in a worker thread with
+   interrupts on and may sleep. */
+
+typedef void work_func (void *aux);
+
+/* A work item. */
+struct work
+  {
+    struct list_elem elem;      /* Element in a pending or delayed list. */
+    work_func *function;        /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNCTION. */
+    struct workqueue *wq;       /* Queue, while pending or delayed. */
+    int64_t due;                /* Tick at which delayed work is due. */
+  };
+
+/* A work queue. */
+struct workqueue
+  {
+    const char *name;           /* Name (for debugging purposes). */
+    struct list pending;        /* Work ready to run. */
+    unsigned max_active;        /* Most items that may run at once. */
+    unsigned active;            /* Items running now. */
+    struct list_elem allelem;   /* Element in list of all queues. */
+
+    /* Statistics. */
+    long long queued_cnt;       /* Items queued. */
+    long long run_cnt;          /* Items run. */
+  };
+
+/* Queue for work with no particular home.
+   Usable once workqueue_start() has been called. */
+extern struct workqueue system_wq;
+
+void workqueue_init (struct workqueue *, const char *name,
+                     unsigned max_active);
+void workqueue_start (void);
+bool workqueue_timer_pending (void);
+void workqueue_tick (int64_t now);
+void workqueue_print_stats (void);
+
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct workqueue *, struct work *);
+bool work_queue_delayed (struct workqueue *, struct work *, int64_t ticks);
+bool work_cancel (struct work *);
+
+#endif /* threads/workqueue.h */
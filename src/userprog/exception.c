@@ -2,10 +2,12 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "threads/flags.h"
 #include "userprog/syscall.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "userprog/process.h"
+#include "userprog/pagedir.h"
 #include "threads/vaddr.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
@@ -20,6 +22,7 @@
 static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
+static void debug_trap (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
@@ -54,7 +57,7 @@ exception_init (void)
      caused indirectly, e.g. #DE can be caused by dividing by
      0.  */
   intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
-  intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
+  intr_register_int (1, 0, INTR_ON, debug_trap, "#DB Debug Exception");
   intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
   intr_register_int (7, 0, INTR_ON, kill,
                      "#NM Device Not Available Exception");
@@ -119,6 +122,34 @@ kill (struct intr_frame *f)
     }
 }
 
+/* Start and end of the code in sysenter.S that runs with the
+   flags SYSENTER left in place. */
+void sysenter_entry (void);
+void sysenter_prologue_end (void);
+
+/* Debug exception handler.
+
+   SYSENTER does not clear TF, so a user process that sets it
+   and then enters the kernel that way takes a single-step trap
+   at sysenter_entry, in kernel mode.  That one is not a kernel
+   bug: clear TF so that the system call can go ahead, and have
+   syscall_handler() put it back in the caller's flags, where it
+   traps in user mode as it would have after `int $0x30'.  Every
+   other debug exception is handled like any other fault. */
+static void
+debug_trap (struct intr_frame *f) 
+{
+  if (f->cs == SEL_KCSEG
+      && (f->eflags & FLAG_TF)
+      && f->eip >= sysenter_entry && f->eip < sysenter_prologue_end)
+    {
+      f->eflags &= ~FLAG_TF;
+      thread_current ()->sysenter_step = true;
+      return;
+    }
+  kill (f);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
@@ -167,12 +198,32 @@ page_fault (struct intr_frame *f)
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
   //printf ("Page fault at %p: %s | %s | %s (esp:%p) (eip:%p) \n",(void*)ROUND_DOWN((uintptr_t)fault_addr,PGSIZE),not_present ? "not present page" : "writing r/o page",write ? "writing access" : "reading access",user ? "user access" : "kernel access",f->esp,f->eip);
-  if(user && !syscall_check_pointer(fault_addr,f->esp))
+  /* 
+  A write to a page shared copy-on-write since a fork, whether by the program itself or by the kernel on its behalf, 
+  gets the process a writable page of its own. 
+  */
+  if(!not_present && write && is_user_vaddr(fault_addr) && process_cow_fault(fault_addr))
+    return;
+
+  if(user && (!not_present || !syscall_check_pointer(fault_addr,f->esp)))
   {
     //printf("invalid address %p, rounded is %p, compared to esp is %p\n",fault_addr,(void*)ROUND_DOWN((uintptr_t)fault_addr,PGSIZE),f->esp);
    	exit(-1);
   }
 
+  /* 
+  A kernel access to a user address that can't be brought in came from get_user() or put_user() in syscall.c, 
+  since other kernel code only touches user buffers those have checked. They leave the address to resume at 
+  in EAX; report the failure by setting EAX to -1. Checked against the user stack pointer saved at system call entry.
+  */
+  if(!user && is_user_vaddr(fault_addr)
+     && (!not_present || !syscall_check_pointer(fault_addr,t->syscall_esp)))
+  {
+    f->eip = (void (*) (void)) f->eax;
+    f->eax = 0xffffffff;
+    return;
+  }
+
    uint8_t *kpage = get_page (PAL_USER);
    if (kpage == NULL)
 	 exit(-1);
@@ -180,11 +231,10 @@ page_fault (struct intr_frame *f)
   if(read_page_from_swap(upage,kpage,t))
   {
 	struct list_elem *e;
-	for(e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+	for(e = list_begin(&t->swap_list); e != list_end(&t->swap_list); e = list_next(e))
 	{
-		struct swap_table_entry *curr = list_entry(e,struct swap_table_entry,elem);
-		//if (curr->taken) printf("curr in swap table is taken with upage %p in thread %s\n",curr->upage,curr->t->name);
-		if(curr->upage == upage && curr->t == t && curr->taken)
+		struct swap_table_entry *curr = list_entry(e,struct swap_table_entry,thread_elem);
+		if(curr->upage == upage)
 		{
 			if (!install_page_handler (upage, kpage, curr->writable)) 
 			{
@@ -193,8 +243,12 @@ page_fault (struct intr_frame *f)
 			}
 			//printf("Swap recovery successful for %p! Here is a character: %c\n",upage,*(char*)kpage);
 			
+			/* the page's only copy is in memory now, so it must go back to swap if it is evicted again. */
+			pagedir_set_dirty(t->pagedir, upage, true);
+			
 			//free the space up
 			curr->taken = false;
+			list_remove(&curr->thread_elem);
 			return;
 		}
 	}
@@ -1,5 +1,6 @@
 #include "userprog/process.h"
 #include <debug.h>
+#include <hash.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
@@ -17,45 +18,98 @@
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #include "threads/vaddr.h"
 #include "devices/partition.h"
 
 static thread_func start_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 void evict_algorithm(void);
-static struct child *get_child_pointer(tid_t tid);
-static void notify_parent(struct thread *my_parent);
+static struct child *find_child(tid_t tid);
+static tid_t start_child(const char *name, thread_func *function, void *aux);
+static void finish_start(bool success);
+static void release_children(struct thread *t);
+static void reap_children(void *aux);
+static bool install_frame (void *upage, void *kpage, bool rw, bool writable);
+static struct frame_table_entry *find_frame (struct thread *t, void *upage);
+static void read_swap_slot (const struct swap_table_entry *, void *kpage);
 static int frame_entry = 0;
 
 struct frame_table_entry
 {
 	struct list_elem elem;
+	struct list_elem thread_elem;	/* in the owner's frame_list. */
 	void *kpage;
 	void *upage;
 	struct thread *t;
-	bool writable;
+	bool writable;		/* may the process write to the page, even if it is mapped read-only for copy-on-write? */
+	bool pinned;		/* true while the frame is being copied, so that it is not evicted. */
 };
 
-
-static struct list args_locations;
-static struct list args_list;
-struct args_location_elem
+/* 
+A process's record of one of its children, shared by the two. It is created by the exec or fork that starts the 
+child and lives in child_table until the parent collects it with wait() or waitany(), or, if the parent exits 
+first, until the child has exited too and the reaper frees it. While the child runs, ELEM is in the parent's 
+child_list, and once it has exited, in the parent's zombie_list. 
+*/
+struct child
 {
-	struct list_elem elem;
-	char *location;
+	int		exit_code;
+	char 	state;
+	struct thread *parent;		/* NULL once the parent has exited. */
+	tid_t 	tid;
+	struct hash_elem table_elem;	/* in child_table. */
+	struct 	list_elem elem;		/* in the parent's child_list or zombie_list, or in reap_list. */
 };
-struct args_list_elem
+
+/* 
+every child record, keyed by tid, which is unique across the system, so that wait() finds a child without a search. 
+child_lock guards the table, the records in it, and the child_list and zombie_list of every thread. 
+a parent waits on its status_change queue with child_lock held. 
+*/
+static struct hash child_table;
+static struct lock child_lock;
+
+/* records whose parent has exited, and reap_work, which frees them in the background. */
+static struct list reap_list;
+static struct work reap_work;
+
+/* Caches for the small records allocated on page faults and exec. */
+struct slab_cache swap_entry_cache;
+struct slab_cache supp_page_cache;
+static struct slab_cache frame_entry_cache;
+static struct slab_cache child_cache;
+
+/* hashes a child record by its tid. */
+static unsigned
+child_hash (const struct hash_elem *e, void *aux UNUSED)
 {
-	struct list_elem elem;
-	char *token;
-};
-/*this function notifies the parent of change in status in the child*/
-static void notify_parent(struct thread *my_parent)
+	return hash_int (hash_entry (e, struct child, table_elem)->tid);
+}
+
+/* orders child records by tid. */
+static bool
+child_less (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
 {
-	lock_acquire(&my_parent->status_change_lock);
-	cond_signal(&my_parent->status_change,&my_parent->status_change_lock);
-	lock_release(&my_parent->status_change_lock);
+	return hash_entry (a, struct child, table_elem)->tid < hash_entry (b, struct child, table_elem)->tid;
+}
+
+/* Sets up the caches used by process and page management. */
+void
+process_init (void)
+{
+	slab_cache_init (&frame_entry_cache, "frame entry", sizeof (struct frame_table_entry));
+	slab_cache_init (&swap_entry_cache, "swap entry", sizeof (struct swap_table_entry));
+	slab_cache_init (&supp_page_cache, "supp page entry", sizeof (struct supp_page_table_entry));
+	slab_cache_init (&child_cache, "child", sizeof (struct child));
+	if (!hash_init (&child_table, child_hash, child_less, NULL))
+		PANIC ("out of memory for the child table");
+	lock_init (&child_lock);
+	lock_set_name (&child_lock, "child");
+	list_init (&reap_list);
+	work_init (&reap_work, reap_children, NULL);
 }
 
 
@@ -78,140 +132,170 @@ process_execute (const char *file_name)
 
   
 	/* Create a new thread to execute FILE_NAME. */
-	tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
+	tid = start_child (file_name, start_process, fn_copy);
 	if (tid == TID_ERROR)
 		palloc_free_page (fn_copy); 
-	//printf("A\n");
-	/* waits for the thread to change to either PROCESS_STARTED or PROCESS_FAILED state */
-	lock_acquire(&thread_current()->status_change_lock);
-	//printf("B\n");
-	struct child *p=get_child_pointer(tid);
-	while(p->state==PROCESS_INITIALIZING)
-		cond_wait(&thread_current()->status_change,&thread_current()->status_change_lock);
-	//printf("C\n");
-	lock_release(&thread_current()->status_change_lock);
-	//printf("D\n");
+	return tid;
+}
+
+/* 
+creates a thread named NAME running FUNCTION(AUX) as a child process of the current one, and waits for it to 
+change to either PROCESS_STARTED or PROCESS_FAILED state. returns its tid if it started, otherwise TID_ERROR. 
+FUNCTION must call finish_start(), and AUX belongs to the caller again if the child could not be created. 
+*/
+static tid_t start_child(const char *name, thread_func *function, void *aux)
+{
+	struct thread *cur = thread_current();
+	struct child *p = slab_alloc(&child_cache);
+	tid_t tid;
+	if(!p)
+		return TID_ERROR;
 	
-	/* checks if the LOAD has not failed */
-	if(p->state==PROCESS_FAILED)
+	/* the child looks its record up in finish_start(), so it must be in the table before the child gets the lock. */
+	lock_acquire(&child_lock);
+	tid = thread_create (name, PRI_DEFAULT, function, aux);
+	if(tid != TID_ERROR)
 	{
-		//printf("load failed\n");
-		return TID_ERROR;
+		p->exit_code	=	-1;
+		p->state		=	PROCESS_INITIALIZING;
+		p->parent		=	cur;
+		p->tid			=	tid;
+		hash_insert(&child_table, &p->table_elem);
+		list_push_back(&cur->child_list, &p->elem);
+		while(p->state==PROCESS_INITIALIZING)
+			wait_queue_wait(&cur->status_change,&child_lock);
+	}
+	
+	/* checks if the LOAD has not failed, in which case no one will wait for the child. */
+	if(tid != TID_ERROR && p->state==PROCESS_FAILED)
+	{
+		hash_delete(&child_table, &p->table_elem);
+		list_remove(&p->elem);
+		tid = TID_ERROR;
 	}
+	lock_release(&child_lock);
+	if(tid == TID_ERROR)
+		slab_free(&child_cache, p);
 	return tid;
 }
 
-/* A thread function that loads a user process and starts it
-   running. */
-static void
-start_process (void *file_name_)
+/* 
+reports to the parent whether the current process, which is being started by exec or fork, could be set up. 
+if not, releases what it holds and exits without running any user code. 
+*/
+static void finish_start(bool success)
 {
-	char *file_name = file_name_;
-	//printf("In start_process with %s\n",file_name);
-	int current=0;
-	struct intr_frame if_;
-	bool success;
-  
-	struct list_elem *e;
-
-	/*The arguments in the command line and tokenised and pushed to the args_list stack. */
-	list_init (&args_list);
-	char *token, *save_ptr;
-	for (token = strtok_r (file_name, " ", &save_ptr); token != NULL; token = strtok_r (NULL, " ", &save_ptr))
+	struct thread *t = thread_current();
+	struct child key;
+	
+	if (!success)
 	{
-		if(current==0)
-		{
-			strlcpy(&(thread_current()->name), (const char *)token, sizeof (thread_current()->name));
-			current++;
-		}
-		struct args_list_elem *temp=(struct args_list_elem *)(malloc(sizeof (struct args_list_elem)));
-		temp->token=token;
-		list_push_front(&args_list,&temp->elem);
+		close_files(t);
+		file_close(t->my_binary);
+		t->my_binary = NULL;
 	}
-  
-  /* Initialize interrupt frame and load executable. */
-	memset (&if_, 0, sizeof if_);
-	if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
-	if_.cs = SEL_UCSEG;
-	if_.eflags = FLAG_IF | FLAG_MBS;
-	success = load ((thread_current()->name), &if_.eip, &if_.esp);
-//printf("H\n");
-	struct thread *my_parent=thread_current()->myself->parent;
 	
-	/* If load failed, quit. */
+	/* the parent is blocked in start_child() until it is told, so it is still there. */
+	key.tid = t->tid;
+	lock_acquire(&child_lock);
+	t->myself = hash_entry(hash_find(&child_table, &key.table_elem), struct child, table_elem);
+	wait_queue_wake_all(&t->myself->parent->status_change);
 	if (!success)
 	{
-		palloc_free_page (file_name);
-		close_files(thread_current());
-		
 		/*
-		If the load has failed, the process changes its state to PROCESS_FAILED and notifies the parent of the change in its status. 
+		If the load has failed, the process changes its state to PROCESS_FAILED and notifies the parent of the change 
+		in its status. the parent frees the record, so the process lets go of it. 
 		*/
-		thread_current()->myself->state		=	PROCESS_FAILED;
-		if(my_parent)
-			notify_parent(my_parent);
+		t->myself->state		=	PROCESS_FAILED;
+		t->myself				=	NULL;
+		lock_release(&child_lock);
 		thread_exit ();
 	}
 	/*
 	If the load is successful, the process changes its state to PROCESS_STARTED and notifies the parent of the change in its status. 
 	*/
-	thread_current()->myself->state			=	PROCESS_STARTED;
-	if(my_parent)
-		notify_parent(my_parent);
-  
-	/* Push the arguments into the memory */
-	list_init (&args_locations);
-	for (e = list_begin (&args_list); e != list_end (&args_list); e = list_next (e))
+	t->myself->state			=	PROCESS_STARTED;
+	lock_release(&child_lock);
+}
+
+/* Splits CMD_LINE into words in place, packing them one after another, each followed by a null terminator, so
+   that they can be copied to the user stack as one block.  Returns the number of words and stores their total size,
+   terminators included, in *SIZE. */
+static int
+pack_args (char *cmd_line, size_t *size)
+{
+	char *dst = cmd_line;
+	char *token, *save_ptr;
+	int argc = 0;
+
+	/* strtok_r() has already moved past the end of each token, so packing it never overwrites text still to come. */
+	for (token = strtok_r (cmd_line, " ", &save_ptr); token != NULL; token = strtok_r (NULL, " ", &save_ptr))
 	{
-		char *temp = list_entry(e, struct args_list_elem, elem)->token;
-		if_.esp -= (strlen(temp)+1);
-		
-		//printf("inside loop addr %x %d\n",(unsigned int)if_.esp,strlen(temp));
-		memcpy(if_.esp,temp,strlen(temp)+1);
-		
-		struct args_location_elem *t=(struct args_location_elem *)malloc(sizeof(struct args_location_elem));
-		t->location	= if_.esp;
-		list_push_back(&args_locations,&t->elem);
+		size_t len = strlen (token) + 1;
+		memmove (dst, token, len);
+		dst += len;
+		argc++;
 	}
-	
-	/*
-		Align the stack pointer to start at the start of the word.
-	*/
-	unsigned int temp = (unsigned int)if_.esp;
-	if_.esp -= (temp%4);
-	if_.esp -=sizeof(int);
-	memset(if_.esp, 0, temp - (unsigned int)if_.esp);
-	
-	/* Push the locations of the arguments into the memory */
-	for (e = list_begin (&args_locations); e != list_end (&args_locations); e = list_next (e))
+	*size = dst - cmd_line;
+	return argc;
+}
+
+/* Sets up main()'s arguments on the user stack that *ESP points to, from the ARGC packed words of total size SIZE in
+   ARGS.  The words go at the top, then the argv array pointing to them, then argv, argc and a null return address.
+   Returns false if they don't fit in the stack's first page. */
+static bool
+push_args (void **esp, const char *args, size_t size, int argc)
+{
+	char *strings = (char *) *esp - size;
+	char **argv = (char **) ROUND_DOWN ((uintptr_t) strings, sizeof (char *)) - (argc + 1);
+	uint32_t *sp = (uint32_t *) argv - 3;
+	int i;
+
+	if ((uint8_t *) sp < (uint8_t *) PHYS_BASE - PGSIZE)
+		return false;
+
+	memcpy (strings, args, size);
+	for (i = 0; i < argc; i++)
 	{
-		char *temp = list_entry(e, struct args_location_elem, elem)->location;
-		if_.esp -= sizeof (char *);
-		memcpy(if_.esp, &temp, sizeof (char *));
+		argv[i] = strings;
+		strings += strlen (strings) + 1;
 	}
+	argv[argc] = NULL;
 
-	/*
-	Push the base address of the arguments into the memory.
-	*/
-	void *arg=if_.esp;
-	if_.esp -= sizeof(char **);
-	memcpy(if_.esp,&arg,sizeof(void **));
-	
-	/*
-	Push the number of arguments into the memory.
-	*/
-	int argc = list_size(&args_locations);
-	if_.esp -= sizeof (int);
-	memcpy(if_.esp, &argc,sizeof (int));
-	
-	if_.esp -= sizeof (void (*) ());
-	
-	/*
-	Mark the file as non-writable.
-	*/
-	thread_current()->my_binary=filesys_open(file_name);
-	file_deny_write(thread_current()->my_binary);
+	sp[2] = (uint32_t) argv;
+	sp[1] = argc;
+	sp[0] = 0;
+	*esp = sp;
+	return true;
+}
+
+/* A thread function that loads a user process and starts it
+   running. */
+static void
+start_process (void *file_name_)
+{
+	char *file_name = file_name_;
+	struct intr_frame if_;
+	bool success;
+	size_t args_size;
+	int argc;
+
+	/* The first word of the command line names the program, and the thread. */
+	argc = pack_args (file_name, &args_size);
+	strlcpy (thread_current()->name, file_name, sizeof thread_current()->name);
+  
+  /* Initialize interrupt frame and load executable. */
+	memset (&if_, 0, sizeof if_);
+	if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	success = (argc > 0
+	           && load (file_name, &if_.eip, &if_.esp)
+	           && push_args (&if_.esp, file_name, args_size, argc));
 	palloc_free_page (file_name);
+	
+	/* If load failed, quit. */
+	finish_start (success);
 
   /* Start the user process by simulating a return from an
      interrupt, implemented by intr_exit (in
@@ -219,22 +303,254 @@ start_process (void *file_name_)
      arguments on the stack in the form of a `struct intr_frame',
      we just point the stack pointer (%esp) to our stack frame
      and jump to it. */
-    //printf("I\n");
   asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
   NOT_REACHED ();
 }
 
-/* This function returns the pointer to the state of the child identified by its tid. */
-static struct child *get_child_pointer(tid_t tid)
+/* What a forked child needs from its parent to start. */
+struct fork_args
+{
+	struct thread *parent;			/* the process being forked. */
+	struct intr_frame if_;			/* the parent's registers at the fork system call. */
+};
+
+static thread_func start_fork NO_RETURN;
+static bool fork_address_space (struct thread *parent);
+
+/* 
+Starts a new process that is a copy of the current one, resuming from the system call whose interrupt frame is IF_ 
+with a return value of 0. Memory is shared copy-on-write, and open files are reopened at the same positions. 
+The parent stays blocked until the copy is complete, so its address space can't change under the child. 
+Returns the new process's thread id, or TID_ERROR if it could not be created.
+*/
+tid_t
+process_fork (const struct intr_frame *if_)
+{
+	struct fork_args args;
+	tid_t tid;
+
+	args.parent = thread_current ();
+	args.if_ = *if_;
+	tid = start_child (thread_current ()->name, start_fork, &args);
+	return tid;
+}
+
+/* A thread function that copies the forking process into the new thread and returns to user mode. */
+static void
+start_fork (void *args_)
+{
+	struct fork_args *args = args_;
+	struct thread *t = thread_current ();
+	struct thread *parent = args->parent;
+	struct intr_frame if_ = args->if_;
+	bool success = false;
+
+	t->pagedir = pagedir_create ();
+	list_init (&t->supp_page_table);
+	t->mapid_next = parent->mapid_next;
+	if (t->pagedir != NULL)
+	{
+		process_activate ();
+		success = fork_address_space (parent) && fork_files (t, parent) && fork_ring (t, parent);
+	}
+	if (success && parent->my_binary != NULL)
+	{
+		t->my_binary = file_reopen (parent->my_binary);
+		if (t->my_binary != NULL)
+			file_deny_write (t->my_binary);
+		else
+			success = false;
+	}
+
+	/* ARGS lives on the parent's stack, which only stays put until the parent is told. */
+	finish_start (success);
+
+	if_.eax = 0;
+	asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+	NOT_REACHED ();
+}
+
+/* 
+gives the current process, which is being forked from PARENT, the frame resident at PARENT's FRAME. the frame is 
+shared, with both mappings made read-only, unless it already has too many sharers to count, in which case the child 
+gets its own copy. returns false if out of memory.
+*/
+static bool
+fork_frame (struct thread *parent, struct frame_table_entry *frame)
+{
+	struct thread *t = thread_current ();
+	void *kpage = pagedir_get_page (parent->pagedir, frame->upage);
+	bool dirty = pagedir_is_dirty (parent->pagedir, frame->upage);
+
+	if (kpage == NULL)
+		return true;
+
+	if (palloc_share_page (kpage))
+	{
+		if (!install_frame (frame->upage, kpage, false, frame->writable))
+		{
+			palloc_free_page (kpage);
+			return false;
+		}
+		pagedir_set_writable (parent->pagedir, frame->upage, false);
+	}
+	else
+	{
+		void *copy = get_page (PAL_USER);
+		if (copy == NULL)
+			return false;
+		page_copy (copy, kpage);
+		if (!install_frame (frame->upage, copy, frame->writable, frame->writable))
+		{
+			palloc_free_page (copy);
+			return false;
+		}
+	}
+
+	/* the page may hold data found nowhere else, in which case eviction must write it to swap. */
+	pagedir_set_dirty (t->pagedir, frame->upage, dirty);
+	return true;
+}
+
+/* 
+gives the current process, which is being forked from PARENT, a copy of PARENT's address space: resident frames 
+are shared copy-on-write, pages in swap are read into frames of the child's own, and pages not yet loaded get 
+copies of their supplemental page table entries. returns false if out of memory.
+*/
+static bool
+fork_address_space (struct thread *parent)
 {
+	struct thread *t = thread_current ();
 	struct list_elem *e;
-	for (e = list_begin (&thread_current()->child_list); e != list_end (&thread_current()->child_list); e = list_next (e))
+
+	for (e = list_begin (&parent->supp_page_table); e != list_end (&parent->supp_page_table); e = list_next (e))
+	{
+		struct supp_page_table_entry *curr = list_entry (e, struct supp_page_table_entry, elem);
+		struct supp_page_table_entry *copy = slab_alloc (&supp_page_cache);
+		if (copy == NULL)
+			return false;
+		*copy = *curr;
+
+		/* reopen each mapped file once, for the first page of its mapping. */
+		if (curr->mmaped_file != NULL)
+		{
+			struct list_elem *f;
+			copy->mmaped_file = NULL;
+			for (f = list_begin (&t->supp_page_table); f != list_end (&t->supp_page_table); f = list_next (f))
+			{
+				struct supp_page_table_entry *prev = list_entry (f, struct supp_page_table_entry, elem);
+				if (prev->mmaped_id == curr->mmaped_id)
+				{
+					copy->mmaped_file = prev->mmaped_file;
+					break;
+				}
+			}
+			if (copy->mmaped_file == NULL)
+				copy->mmaped_file = file_reopen (curr->mmaped_file);
+			if (copy->mmaped_file == NULL)
+			{
+				slab_free (&supp_page_cache, copy);
+				return false;
+			}
+		}
+		list_push_back (&t->supp_page_table, &copy->elem);
+	}
+
+	/* copying may evict other frames, so the frame being copied is pinned to keep its list element valid. */
+	for (e = list_begin (&parent->frame_list); e != list_end (&parent->frame_list); e = list_next (e))
 	{
-		struct child *temp = (struct child *)list_entry(e, struct child, elem);
-		if(temp->tid==tid)
-			return temp;
+		struct frame_table_entry *curr = list_entry (e, struct frame_table_entry, thread_elem);
+		bool success;
+		curr->pinned = true;
+		success = fork_frame (parent, curr);
+		curr->pinned = false;
+		if (!success)
+			return false;
 	}
-	return NULL;
+
+	/* 
+	this also picks up any of the parent's frames that were evicted while the loop above ran, except those the 
+	child already has. 
+	*/
+	for (e = list_begin (&parent->swap_list); e != list_end (&parent->swap_list); e = list_next (e))
+	{
+		struct swap_table_entry *curr = list_entry (e, struct swap_table_entry, thread_elem);
+		void *kpage;
+		if (pagedir_get_page (t->pagedir, curr->upage) != NULL)
+			continue;
+		kpage = get_page (PAL_USER);
+		if (kpage == NULL)
+			return false;
+		read_swap_slot (curr, kpage);
+		if (!install_frame (curr->upage, kpage, curr->writable, curr->writable))
+		{
+			palloc_free_page (kpage);
+			return false;
+		}
+		pagedir_set_dirty (t->pagedir, curr->upage, true);
+	}
+	return true;
+}
+
+/* 
+handles a write fault at FAULT_ADDR, a user address, by the current process. if the page is mapped read-only only 
+because it is shared copy-on-write, gives the process a writable page with the same contents, copying it unless 
+no other process shares it any more, and returns true. returns false if the write is not allowed or there is no 
+memory for the copy.
+*/
+bool
+process_cow_fault (void *fault_addr)
+{
+	struct thread *t = thread_current ();
+	void *upage = pg_round_down (fault_addr);
+	struct frame_table_entry *frame = find_frame (t, upage);
+	void *kpage;
+
+	if (frame == NULL || !frame->writable)
+		return false;
+	if (!palloc_page_shared (frame->kpage))
+	{
+		pagedir_set_writable (t->pagedir, upage, true);
+		return true;
+	}
+
+	frame->pinned = true;
+	kpage = get_page (PAL_USER);
+	frame->pinned = false;
+	if (kpage == NULL)
+		return false;
+
+	/* the other sharers may have gone while get_page() waited. */
+	if (!palloc_page_shared (frame->kpage))
+	{
+		palloc_free_page (kpage);
+		pagedir_set_writable (t->pagedir, upage, true);
+		return true;
+	}
+
+	page_copy (kpage, frame->kpage);
+	bool dirty = pagedir_is_dirty (t->pagedir, upage);
+	pagedir_clear_page (t->pagedir, upage);
+	palloc_free_page (frame->kpage);
+	frame->kpage = kpage;
+	/* the page table is already there, so this can't fail. */
+	pagedir_set_page (t->pagedir, upage, kpage, true);
+	pagedir_set_dirty (t->pagedir, upage, dirty);
+	return true;
+}
+
+/* This function returns the pointer to the state of the current process's child identified by its tid, or NULL if it 
+   has no such child. child_lock must be held. */
+static struct child *find_child(tid_t tid)
+{
+	struct child key;
+	struct hash_elem *e;
+	key.tid = tid;
+	e = hash_find(&child_table, &key.table_elem);
+	if(e == NULL)
+		return NULL;
+	struct child *temp = hash_entry(e, struct child, table_elem);
+	return temp->parent == thread_current() ? temp : NULL;
 }
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
@@ -248,12 +564,11 @@ static struct child *get_child_pointer(tid_t tid)
 int
 process_wait (tid_t child_tid) 
 {
-	lock_acquire(&thread_current()->status_change_lock);
-	struct child *p	=	get_child_pointer(child_tid);
+	lock_acquire(&child_lock);
+	struct child *p	=	find_child(child_tid);
 	if(!p)
 	{
-		//printf("Mistake here\n");
-		lock_release(&thread_current()->status_change_lock);
+		lock_release(&child_lock);
 		return -1;
 	}
 	
@@ -261,18 +576,176 @@ process_wait (tid_t child_tid)
 		Wait for child to change its status from PROCESS_STARTED to PROCESS_EXITED
 	*/
 	while(p->state==PROCESS_STARTED)
-		cond_wait(&thread_current()->status_change,&thread_current()->status_change_lock);
+		wait_queue_wait(&thread_current()->status_change,&child_lock);
 	
 	/*
 		Extract the child's exit code and return it. 
 	*/
 	int ret	=	p->exit_code;
 	list_remove(&p->elem);
-	free(p);
-	lock_release(&thread_current()->status_change_lock);
+	hash_delete(&child_table, &p->table_elem);
+	lock_release(&child_lock);
+	slab_free(&child_cache, p);
 	return ret;	
 }
 
+/* 
+Waits for any child of the current process to exit, children that have already exited first, oldest first. 
+Returns the child's tid and stores its exit status in *STATUS. Returns TID_ERROR at once if there is no child left 
+to wait for. 
+*/
+tid_t
+process_wait_any (int *status)
+{
+	struct thread *cur = thread_current();
+	lock_acquire(&child_lock);
+	while(list_empty(&cur->zombie_list) && !list_empty(&cur->child_list))
+		wait_queue_wait(&cur->status_change,&child_lock);
+	if(list_empty(&cur->zombie_list))
+	{
+		lock_release(&child_lock);
+		return TID_ERROR;
+	}
+	struct child *p = list_entry(list_pop_front(&cur->zombie_list), struct child, elem);
+	hash_delete(&child_table, &p->table_elem);
+	lock_release(&child_lock);
+	
+	tid_t tid = p->tid;
+	*status = p->exit_code;
+	slab_free(&child_cache, p);
+	return tid;
+}
+
+/* 
+Hands process T's own record, if it has one, to its parent, or to the reaper if the parent has exited, and lets go of its records 
+of its children: those still running are orphaned, and free their own records when they exit, and those that have 
+exited go to the reaper, so that T's exit doesn't wait on freeing them. 
+*/
+static void
+release_children (struct thread *t)
+{
+	struct child *self = t->myself;
+	bool reap;
+	
+	lock_acquire(&child_lock);
+	/* a process killed by the kernel never reached exit(), and reports -1, which the record starts with. */
+	if(self && self->state==PROCESS_STARTED)
+	{
+		self->state = PROCESS_EXITED;
+		if(self->parent)
+		{
+			list_remove(&self->elem);
+			list_push_back(&self->parent->zombie_list, &self->elem);
+			wait_queue_wake_all(&self->parent->status_change);
+		}
+		else
+			list_push_back(&reap_list, &self->elem);
+	}
+	t->myself = NULL;
+	
+	while(!list_empty(&t->child_list))
+		list_entry(list_pop_front(&t->child_list), struct child, elem)->parent = NULL;
+	list_splice(list_end(&reap_list), list_begin(&t->zombie_list), list_end(&t->zombie_list));
+	reap = !list_empty(&reap_list);
+	lock_release(&child_lock);
+	
+	if(reap)
+		work_queue(&system_wq, &reap_work);
+}
+
+/* The reaper: frees the records in reap_list. */
+static void
+reap_children (void *aux UNUSED)
+{
+	struct list dead;
+	list_init(&dead);
+	
+	lock_acquire(&child_lock);
+	while(!list_empty(&reap_list))
+	{
+		struct child *p = list_entry(list_pop_front(&reap_list), struct child, elem);
+		hash_delete(&child_table, &p->table_elem);
+		list_push_back(&dead, &p->elem);
+	}
+	lock_release(&child_lock);
+	
+	while(!list_empty(&dead))
+		slab_free(&child_cache, list_entry(list_pop_front(&dead), struct child, elem));
+}
+
+/* Releases thread T's entries in the frame and swap tables and
+   its supplemental page table, closing the files it has mapped,
+   in one pass over each.  The frames themselves are freed along
+   with T's page directory.  Any dirty mapped pages must already
+   have been written back. */
+static void
+free_address_space (struct thread *t)
+{
+  while (!list_empty (&t->frame_list))
+    {
+      struct list_elem *e = list_pop_front (&t->frame_list);
+      struct frame_table_entry *frame
+        = list_entry (e, struct frame_table_entry, thread_elem);
+
+      list_remove (&frame->elem);
+      slab_free (&frame_entry_cache, frame);
+    }
+
+  while (!list_empty (&t->swap_list))
+    {
+      struct list_elem *e = list_pop_front (&t->swap_list);
+      list_entry (e, struct swap_table_entry, thread_elem)->taken = false;
+    }
+
+  /* The pages of a mapping are adjacent in the table and share
+     one file, which is closed with the last of them. */
+  while (!list_empty (&t->supp_page_table))
+    {
+      struct list_elem *e = list_pop_front (&t->supp_page_table);
+      struct supp_page_table_entry *page
+        = list_entry (e, struct supp_page_table_entry, elem);
+
+      if (page->mmaped_file != NULL
+          && (list_empty (&t->supp_page_table)
+              || list_entry (list_front (&t->supp_page_table),
+                             struct supp_page_table_entry,
+                             elem)->mmaped_file != page->mmaped_file))
+        file_close (page->mmaped_file);
+      slab_free (&supp_page_cache, page);
+    }
+}
+
+/* Removes user page UPAGE from thread T's address space,
+   freeing the frame or swap slot that holds it. */
+void
+process_drop_page (struct thread *t, void *upage)
+{
+  struct frame_table_entry *frame = find_frame (t, upage);
+  struct list_elem *e;
+
+  if (frame != NULL)
+    {
+      list_remove (&frame->elem);
+      list_remove (&frame->thread_elem);
+      slab_free (&frame_entry_cache, frame);
+    }
+  palloc_free_page (pagedir_get_page (t->pagedir, upage));
+  pagedir_clear_page (t->pagedir, upage);
+
+  for (e = list_begin (&t->swap_list); e != list_end (&t->swap_list);
+       e = list_next (e))
+    {
+      struct swap_table_entry *slot
+        = list_entry (e, struct swap_table_entry, thread_elem);
+      if (slot->upage == upage)
+        {
+          slot->taken = false;
+          list_remove (&slot->thread_elem);
+          break;
+        }
+    }
+}
+
 /* Free the current process's resources. */
 void
 process_exit (void)
@@ -285,6 +758,8 @@ process_exit (void)
   pd = cur->pagedir;
   if (pd != NULL) 
     {
+      free_address_space (cur);
+
       /* Correct ordering here is crucial.  We must set
          cur->pagedir to NULL before switching page directories,
          so that a timer interrupt can't switch back to the
@@ -296,34 +771,18 @@ process_exit (void)
       pagedir_activate (NULL);
       pagedir_destroy (pd);
     }
+
+  /* Kernel threads, such as the one running the initial
+     program, can have child processes too. */
+  release_children (cur);
 }
 
 /* Exit the user thread and notify the parent of the new status. */
 void user_process_exit(int exit_code)
 {
 	printf("%s: exit(%d)\n", thread_current()->name, exit_code);
-	//thread_current()->myself->exit_flag	=	true;
+	/* the parent is told in process_exit(), once the process's memory has been freed. */
 	thread_current()->myself->exit_code		=	exit_code;
-	thread_current()->myself->state			=	PROCESS_EXITED;
-	struct thread *my_parent=thread_current()->myself->parent;
-	if(my_parent)
-		notify_parent(my_parent);
-	else
-		free(thread_current()->myself);
-		
-	/*
-		Free the memory associated with each of the thread's child if the child has completed execution.
-	*/
-	struct list_elem *e;
-	for (e = list_begin(&thread_current()->child_list); e != list_end(&thread_current ()->child_list);)
-	{
-		struct child *temp=list_entry(e,struct child,elem);
-		e=list_next(e);
-		if(temp->state!=PROCESS_STARTED)
-			free(temp);
-		else
-			temp->parent=NULL;
-	}
 	
 	/*Close the files that were opened by the thread */
 	close_files(thread_current());
@@ -425,7 +884,7 @@ void init_swap_table(void)
   int i;
   for(i = 0; i < total_sector_pages; i++)
   {
-  	struct swap_table_entry* curr = malloc(sizeof(struct swap_table_entry));
+  	struct swap_table_entry* curr = slab_alloc(&swap_entry_cache);
   	curr->slot = i * (PGSIZE/BLOCK_SECTOR_SIZE);
   	curr->taken = 0;
   	list_push_back(&swap_table,&curr->elem);
@@ -435,6 +894,8 @@ void init_swap_table(void)
 /* Loads an ELF executable from FILE_NAME into the current thread.
    Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
+   On success, the executable stays open as the thread's
+   my_binary, denied writes, for loading pages on demand.
    Returns true if successful, false otherwise. */
 bool
 load (const char *file_name, void (**eip) (void), void **esp) 
@@ -544,10 +1005,13 @@ load (const char *file_name, void (**eip) (void), void **esp)
   *eip = (void (*) (void)) ehdr.e_entry;
 
   success = true;
+  file_deny_write (file);
+  t->my_binary = file;
 
  done:
   /* We arrive here whether the load is successful or not. */
-  file_close (file);
+  if (!success)
+    file_close (file);
   return success;
 }
 
@@ -630,7 +1094,7 @@ load_segment (off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
       
-      struct supp_page_table_entry *curr = malloc(sizeof(struct supp_page_table_entry));
+      struct supp_page_table_entry *curr = slab_alloc(&supp_page_cache);
       curr->upage = upage;
       curr->page_read_bytes = page_read_bytes;
       curr->page_zero_bytes = page_zero_bytes;
@@ -687,21 +1151,33 @@ bool install_page_handler(void *upage, void *kpage, bool writable)
    if memory allocation fails. */
 static bool
 install_page (void *upage, void *kpage, bool writable)
+{
+  return install_frame (upage, kpage, writable, writable);
+}
+
+/* Like install_page(), but maps KPAGE writable only if RW is
+   true, while recording WRITABLE as whether the process may
+   write to it.  A page shared copy-on-write has RW false and
+   WRITABLE true. */
+static bool
+install_frame (void *upage, void *kpage, bool rw, bool writable)
 {
   struct thread *t = thread_current ();
   //printf("!\n");
   /* Verify that there's not already a page at that virtual
      address, then map our page there. */
   bool success = (pagedir_get_page (t->pagedir, upage) == NULL
-          && pagedir_set_page (t->pagedir, upage, kpage, writable));
+          && pagedir_set_page (t->pagedir, upage, kpage, rw));
  if(success)
  {
- 	struct frame_table_entry* curr = malloc(sizeof(struct frame_table_entry));
+ 	struct frame_table_entry* curr = slab_alloc(&frame_entry_cache);
  	curr->kpage = kpage;
  	curr->upage = upage;
  	curr->t = thread_current();
  	curr->writable = writable;
+ 	curr->pinned = false;
  	list_push_back(&frame_table,&curr->elem);
+ 	list_push_back(&t->frame_list,&curr->thread_elem);
  	//printf("Page table entry for %s thread at %p\n",t->name,upage);
  }
  else
@@ -719,21 +1195,23 @@ install_page (void *upage, void *kpage, bool writable)
  return success;
 }
 
-/* If possible, write the page at upage to the swap device. Must have created swap_table_entry with upage. Returns true on success. */
+/* If possible, write the page at upage to the swap device. Must have created swap_table_entry with upage. The page is 
+   read through its kernel address, so it need not belong to the current thread. Returns true on success. */
 bool write_page_to_swap(void* upage, struct thread *t)
 {
 	struct list_elem *e;
-	for(e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+	for(e = list_begin(&t->swap_list); e != list_end(&t->swap_list); e = list_next(e))
 	{
-		struct swap_table_entry *curr = list_entry(e,struct swap_table_entry,elem);
-		if(curr->upage == upage && curr->t == t)
+		struct swap_table_entry *curr = list_entry(e,struct swap_table_entry,thread_elem);
+		if(curr->upage == upage)
 		{
+			char *kpage = pagedir_get_page(t->pagedir, upage);
 			int i;
 			int num_sectors = PGSIZE/BLOCK_SECTOR_SIZE;
 			for(i = 0; i < num_sectors; i++)
 			{
 				block_sector_t slot = curr->slot + i;
-				block_write(swap_block,slot, (char*) upage + i*BLOCK_SECTOR_SIZE);
+				block_write(swap_block,slot, kpage + i*BLOCK_SECTOR_SIZE);
 			}
 			return true;
 		}
@@ -741,28 +1219,89 @@ bool write_page_to_swap(void* upage, struct thread *t)
 	return false;
 }
 
+/* Reads the page held in swap slot CURR into KPAGE. */
+static void read_swap_slot(const struct swap_table_entry *curr, void *kpage)
+{
+	int i;
+	int num_sectors = PGSIZE/BLOCK_SECTOR_SIZE;
+	for(i = 0; i < num_sectors; i++)
+	{
+		block_sector_t slot = curr->slot + i;
+		block_read(swap_block,slot, (char*) kpage + i*BLOCK_SECTOR_SIZE);
+	}
+}
+
 /*Find the address at upage if present in the swap device, and write it to kpage. The user should also free the entry for other memory. Return true on success.*/
 bool read_page_from_swap(void* upage, void* kpage, struct thread *t)
 {
 	struct list_elem *e;
-	for(e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+	for(e = list_begin(&t->swap_list); e != list_end(&t->swap_list); e = list_next(e))
 	{
-		struct swap_table_entry *curr = list_entry(e,struct swap_table_entry,elem);
-		if(curr->upage == upage && curr->t == t)
+		struct swap_table_entry *curr = list_entry(e,struct swap_table_entry,thread_elem);
+		if(curr->upage == upage)
 		{
-			int i;
-			int num_sectors = PGSIZE/BLOCK_SECTOR_SIZE;
-			for(i = 0; i < num_sectors; i++)
-			{
-				block_sector_t slot = curr->slot + i;
-				block_read(swap_block,slot, (char*) kpage + i*BLOCK_SECTOR_SIZE);
-			}
+			read_swap_slot(curr, kpage);
 			return true;
 		}
 	}
 	return false;
 }
 
+/* Returns thread T's frame table entry for the frame mapped at user page UPAGE, or NULL if it has none. */
+static struct frame_table_entry *find_frame(struct thread *t, void *upage)
+{
+	void *kpage = pagedir_get_page(t->pagedir, upage);
+	struct list_elem *e;
+	if(kpage == NULL)
+		return NULL;
+	for(e = list_begin(&t->frame_list); e != list_end(&t->frame_list); e = list_next(e))
+	{
+		struct frame_table_entry *curr = list_entry(e,struct frame_table_entry,thread_elem);
+		if(curr->upage == upage && curr->kpage == kpage)
+			return curr;
+	}
+	return NULL;
+}
+
+/* Evicts the frame described by CURR from the frame table.
+   A dirty frame is written to swap first; a clean one is simply dropped. A frame shared copy-on-write is only 
+   unmapped from CURR's process, and stays in memory for the others. */
+static void evict_frame(struct frame_table_entry *curr)
+{
+	if(pagedir_is_dirty(curr->t->pagedir,curr->upage)) 
+	{
+		struct list_elem *e;
+		bool space_in_swap = false;
+		
+		//add entry to swap table
+		for(e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
+		{
+			struct swap_table_entry *curr_swap = list_entry(e,struct swap_table_entry,elem);
+			if(!curr_swap->taken)
+			{
+				space_in_swap = true;
+				curr_swap->upage = curr->upage;
+				curr_swap->t = curr->t;
+				curr_swap->writable = curr->writable;
+				curr_swap->taken = true;
+				list_push_back(&curr->t->swap_list,&curr_swap->thread_elem);
+				break;
+			}
+		}
+		if(!space_in_swap) PANIC("Swap full");
+		
+		//write to swap device
+		if(!write_page_to_swap(curr->upage,curr->t)) PANIC("Swap write failed");
+	}
+	//evict page
+	void *kpage =  pagedir_get_page(curr->t->pagedir,curr->upage);
+	palloc_free_page(kpage);
+	pagedir_clear_page(curr->t->pagedir,curr->upage);
+	list_remove(&curr->elem);
+	list_remove(&curr->thread_elem);
+	slab_free(&frame_entry_cache, curr);
+}
+
 void evict_algorithm()
 {	
 	bool begin = false;
@@ -781,47 +1320,35 @@ void evict_algorithm()
     		
     		struct frame_table_entry *curr = list_entry(e,struct frame_table_entry,elem);
     		frame_entry = (frame_entry+1)%(list_size(&frame_table)-1);
-    		if(curr->t == thread_current() && pagedir_is_accessed(curr->t->pagedir,curr->upage))
+    		if(curr->pinned)
+    			e = list_next(e);
+    		else if(curr->t == thread_current() && pagedir_is_accessed(curr->t->pagedir,curr->upage))
     		{
     			pagedir_set_accessed(curr->t->pagedir,curr->upage,false);
     			e = list_next(e);
     		}
     		else
     		{
-    			if(curr->t == thread_current() && pagedir_is_dirty(curr->t->pagedir,curr->upage)) 
-    			{
-    					struct list_elem *e;
-    					bool space_in_swap = false;
-    					
-    					//add entry to swap table
-						for(e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
-						{
-							struct swap_table_entry *curr_swap = list_entry(e,struct swap_table_entry,elem);
-							if(!curr_swap->taken)
-							{
-								space_in_swap = true;
-								curr_swap->upage = curr->upage;
-								curr_swap->t = curr->t;
-								curr_swap->writable = curr->writable;
-								curr_swap->taken = true;
-								break;
-							}
-						}
-						if(!space_in_swap) PANIC("Swap full");
-						
-						//write to swap device
-						if(!write_page_to_swap(curr->upage,curr->t)) PANIC("Swap write failed");
-						//else printf("Swap creation successful for %p upage! Here is a char: %c\n",curr->upage,*(char*)curr->upage);
-    			}
-    			//evict page and return
-			   void *kpage =  pagedir_get_page(curr->t->pagedir,curr->upage);
-			   //printf("eviction succeeded for %p!\n",curr->upage);
-			   palloc_free_page(kpage);
-			   pagedir_clear_page(curr->t->pagedir,curr->upage);
-			   list_remove(e);
-			   free(curr);
-			   return;
+    			evict_frame(curr);
+    			return;
     		}
     	}
     }
 }
+
+/* Evicts one user frame that was borrowed from the kernel pool, so that the kernel can have the page back.
+   Returns true if a frame was evicted. */
+bool evict_lent_frame(void)
+{
+	struct list_elem *e;
+	for(e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e))
+	{
+		struct frame_table_entry *curr = list_entry(e,struct frame_table_entry,elem);
+		if(palloc_lent_by_kernel(curr->kpage) && !curr->pinned)
+		{
+			evict_frame(curr);
+			return true;
+		}
+	}
+	return false;
+}
@@ -4,12 +4,20 @@
 #include "filesys/off_t.h"
 #include "threads/thread.h"
 #include "devices/block.h"
+#include "threads/slab.h"
+#include "threads/interrupt.h"
 
+void process_init (void);
 tid_t process_execute (const char *file_name);
+tid_t process_fork (const struct intr_frame *);
+bool process_cow_fault (void *fault_addr);
 int process_wait (tid_t);
+tid_t process_wait_any (int *status);
 void user_process_exit(int exit_code);
 void evict_algorithm(void);
+bool evict_lent_frame(void);
 void process_exit (void);
+void process_drop_page (struct thread *t, void *upage);
 void process_activate (void);
 bool install_page_handler (void *upage, void *kpage, bool writable);
 bool read_page_from_swap(void* upage, void* kpage, struct thread *t);
@@ -19,9 +27,14 @@ struct list frame_table;			/* Lists frames that contain a user page*/
 struct list swap_table;
 struct block *swap_block;
 
+/* Caches for the entries of the tables above. */
+extern struct slab_cache swap_entry_cache;
+extern struct slab_cache supp_page_cache;
+
 struct swap_table_entry
 {
 	struct list_elem elem;
+	struct list_elem thread_elem;	/* in the owner's swap_list, while taken. */
 	void *upage;
 	struct thread *t;
 	bool writable;
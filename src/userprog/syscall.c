@@ -1,15 +1,20 @@
 #include "userprog/syscall.h"
 #include "userprog/process.h"
+#include <console.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <syscall-nr.h>
+#include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "lib/user/syscall.h"
+#include "lib/kernel/bitmap.h"
 #include "lib/round.h"
 
 #include "userprog/pagedir.h"
@@ -20,9 +25,11 @@
 #include "devices/shutdown.h"
 #define min(a,b)	(a>b)?b:a
 #define STACK_SZ 1024*1024*8
+#define FD_MIN 2			/* lowest FD handed out for files, after STDIN and STDOUT. */
+#define FD_MAX 1024			/* upper bound on the size of a thread's descriptor table. */
+#define NAME_BUF 15			/* file names must be shorter than this. */
 
-unsigned BUFFER_SIZE	=	256;
-static char* esp;
+#define BUFFER_SIZE 256		/* bytes copied out of user memory at a time by stdout_write(). */
 
 /*indicates the number of arguments required by each system call. Comments copied from syscall-nr.h*/
 int num_args[]	=
@@ -42,15 +49,28 @@ int num_args[]	=
 	1,	/* Close a file. */
 	2, 	/* mmap */
 	1,  /* munmap */
+	1,	/* Change the current directory. */
+	1,	/* Create a directory. */
+	2,	/* Reads a directory entry. */
+	1,	/* Tests if a fd represents a directory. */
+	1,	/* Returns the inode number for a fd. */
+	4,	/* Read from a file at a given position. */
+	4,	/* Write to a file at a given position. */
+	3,	/* Read from a file into several buffers. */
+	3,	/* Write to a file from several buffers. */
+	1,	/* Map a system call ring. */
+	1,	/* Carry out requests queued in the ring. */
+	0,	/* Duplicate the calling process. */
+	1,	/* Wait for any child process to die. */
 };
 
 /* utility functions */
 struct file * get_file_pointer(int fd);
-struct file_elem * get_file_element(int fd);
+static int fd_alloc(struct thread *t, struct file *f);
 void close_files(struct thread *t);
 bool check_pointer_unmapped(void *ptr);
 bool check_pointer(void *ptr);
-bool check_filename(const char *file);
+bool copy_filename(char *name, const char *file);
 int stdout_write (const char *buffer, unsigned size);
 
 
@@ -64,12 +84,21 @@ int open (const char *file);
 int read (int fd, void *buffer, unsigned size);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
+int pread (int fd, void *buffer, unsigned size, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int ring_setup (void *addr);
+int ring_enter (unsigned to_submit);
+int sys_fork (struct intr_frame *f);
 int filesize (int fd);
 int exec (const char * cmd_line);
 void close (int fd);
 int wait (int pid);
+pid_t waitany (int *status);
 void halt(void);
 void munmap (mapid_t mapid);
+static void mmap_write_back (struct thread *t, bool all, mapid_t mapid);
 mapid_t mmap (int fd, void *addr);
 
 
@@ -110,103 +139,250 @@ bool syscall_check_pointer(void *ptr, char *esp_ptr)
 }
 
 
-/* closes the files opened by thread t	*/
+/* 
+Reads a byte at user virtual address UADDR, which must be below PHYS_BASE. Returns the byte value if successful, 
+or -1 if the access faulted. The page fault handler recovers a kernel fault on a bad user address by resuming 
+at the address left in EAX with EAX set to -1.
+*/
+static inline int get_user(const uint8_t *uaddr)
+{
+	int result;
+	asm ("movl $1f, %0; movzbl %1, %0; 1:" : "=&a" (result) : "m" (*uaddr));
+	return result;
+}
+
+/* writes BYTE to user address UDST, which must be below PHYS_BASE. returns false if the access faulted. */
+static inline bool put_user(uint8_t *udst, uint8_t byte)
+{
+	int error_code;
+	asm ("movl $1f, %0; movb %b2, %1; 1:" : "=&a" (error_code), "=m" (*udst) : "q" (byte));
+	return error_code != -1;
+}
+
+/* returns true if the SIZE bytes starting at UADDR lie entirely below PHYS_BASE. */
+static inline bool is_user_range(const void *uaddr, size_t size)
+{
+	return is_user_vaddr(uaddr) && size <= (size_t) ((const uint8_t *) PHYS_BASE - (const uint8_t *) uaddr);
+}
+
+/* copies SIZE bytes from user address USRC to kernel buffer DST. returns false if any byte could not be read. */
+bool copy_from_user(void *dst_, const void *usrc_, size_t size)
+{
+	uint8_t *dst = dst_;
+	const uint8_t *usrc = usrc_;
+	if(!is_user_range(usrc, size))
+		return false;
+	for(; size > 0; size--)
+	{
+		int c = get_user(usrc++);
+		if(c < 0)
+			return false;
+		*dst++ = c;
+	}
+	return true;
+}
+
+/* copies SIZE bytes from kernel buffer SRC to user address UDST. returns false if any byte could not be written. */
+bool copy_to_user(void *udst_, const void *src_, size_t size)
+{
+	uint8_t *udst = udst_;
+	const uint8_t *src = src_;
+	if(!is_user_range(udst, size))
+		return false;
+	for(; size > 0; size--)
+		if(!put_user(udst++, *src++))
+			return false;
+	return true;
+}
+
+/* 
+copies the string at user address USRC into DST, copying at most SIZE bytes including the null terminator. 
+returns the length of the string, or SIZE if it did not fit (DST is then not terminated), or -1 if it could not be read.
+*/
+int strncpy_from_user(char *dst, const char *usrc, size_t size)
+{
+	size_t len;
+	for(len = 0; len < size; len++)
+	{
+		int c = is_user_vaddr(usrc + len) ? get_user((const uint8_t *) usrc + len) : -1;
+		if(c < 0)
+			return -1;
+		dst[len] = c;
+		if(c == '\0')
+			return len;
+	}
+	return size;
+}
+
+/* 
+checks that the SIZE bytes at user address UADDR can be read, and written too if WRITE is true, by touching one byte 
+in each page. the kernel may then access the buffer directly: any page the check brought in that is evicted again 
+is faulted back in on access.
+*/
+bool check_user_buffer(const void *uaddr, size_t size, bool write)
+{
+	uint8_t *p = (uint8_t *) uaddr;
+	uint8_t *end = p + size;
+	if(!is_user_range(uaddr, size))
+		return false;
+	while(p < end)
+	{
+		int c = get_user(p);
+		if(c < 0 || (write && !put_user(p, c)))
+			return false;
+		p = (uint8_t *) pg_round_down(p) + PGSIZE;
+	}
+	return true;
+}
+
+/* closes the files opened by thread t and frees its descriptor table. */
 void close_files(struct thread *t)
 {
-	struct list_elem *e;
-	
-	/*
-	iterates through the list of the files opened by the thread and closes each one of them along with freeing the memory associated.
-	*/
-	for (e = list_begin(&t->file_list); e != list_end(&t->file_list);)
+	int fd;
+	for (fd = FD_MIN; fd < t->fd_cnt; fd++)
+		if(t->fd_table[fd])
+			file_close(t->fd_table[fd]);
+	free(t->fd_table);
+	bitmap_destroy(t->fd_map);
+	t->fd_table = NULL;
+	t->fd_map = NULL;
+	t->fd_cnt = 0;
+}
+
+/* 
+doubles the size of thread t's descriptor table, up to FD_MAX. It is only called when every slot is in use, 
+so the new bitmap starts with all of the old slots marked. returns false if the table cannot grow.
+*/
+static bool fd_table_grow(struct thread *t)
+{
+	int new_cnt = t->fd_cnt ? t->fd_cnt * 2 : 16;
+	if(new_cnt > FD_MAX)
+		new_cnt = FD_MAX;
+	if(new_cnt <= t->fd_cnt)
+		return false;
+
+	struct file **table = realloc(t->fd_table, new_cnt * sizeof *table);
+	if(!table)
+		return false;
+	t->fd_table = table;
+	struct bitmap *map = bitmap_create(new_cnt);
+	if(!map)
+		return false;
+	memset(table + t->fd_cnt, 0, (new_cnt - t->fd_cnt) * sizeof *table);
+	bitmap_set_multiple(map, 0, t->fd_cnt ? t->fd_cnt : FD_MIN, true);
+	bitmap_destroy(t->fd_map);
+	t->fd_map = map;
+	t->fd_cnt = new_cnt;
+	return true;
+}
+
+/* 
+gives thread t, which is being forked from thread parent, a copy of parent's descriptor table, with each file 
+reopened at the same position so that the same FDs name the same files. the positions are not shared afterwards. 
+returns false if out of memory; close_files() cleans up after a partial copy.
+*/
+bool fork_files(struct thread *t, struct thread *parent)
+{
+	while(t->fd_cnt < parent->fd_cnt)
+		if(!fd_table_grow(t))
+			return false;
+	int fd;
+	for (fd = FD_MIN; fd < parent->fd_cnt; fd++)
+		if(parent->fd_table[fd])
+		{
+			struct file *f = file_reopen(parent->fd_table[fd]);
+			if(!f)
+				return false;
+			file_seek(f, file_tell(parent->fd_table[fd]));
+			t->fd_table[fd] = f;
+			bitmap_mark(t->fd_map, fd);
+		}
+	return true;
+}
+
+/* 
+installs f in the lowest free slot of thread t's descriptor table, growing the table if it is full. 
+returns the new FD, or -1 if the table cannot hold another file.
+*/
+static int fd_alloc(struct thread *t, struct file *f)
+{
+	size_t fd = BITMAP_ERROR;
+	if(t->fd_map)
+		fd = bitmap_scan_and_flip(t->fd_map, FD_MIN, 1, false);
+	if(fd == BITMAP_ERROR)
 	{
-		struct list_elem *temp=list_next(e);
-		struct file_elem *ele=list_entry(e, struct file_elem, elem);
-		file_close(ele->file_pointer);
-		list_remove(&ele->elem);
-		free(ele);
-		e=temp;
+		if(!fd_table_grow(t))
+			return -1;
+		fd = bitmap_scan_and_flip(t->fd_map, FD_MIN, 1, false);
 	}
+	t->fd_table[fd] = f;
+	return fd;
 }
 
-/* writes the buffer to STDOUT using the putbuf function. */
+/* 
+writes the user buffer to STDOUT using the putbuf function. the console lock is taken once for the whole write, 
+which keeps it in one piece. each chunk is copied into the kernel first, since the serial queue is filled with 
+interrupts off, when a page fault in user memory can't be taken. 
+*/
 int stdout_write (const char *buffer, unsigned size)
 {
+	char chunk[BUFFER_SIZE];
 	unsigned total	=	0;
+	acquire_console();
 	while (size > 0)
 	{
 		unsigned  size_to_be_written	=	min(BUFFER_SIZE,size);
 		
 		/* pushes BUFFER_SIZE characters to the standard output stream. */
-		putbuf (buffer, size_to_be_written);
+		memcpy (chunk, buffer, size_to_be_written);
+		putbuf (chunk, size_to_be_written);
 		buffer = (const char*)buffer + BUFFER_SIZE;
 		size -= size_to_be_written;
 		total+=size_to_be_written;
 	}
+	release_console();
 	return total;
 }
 
-/* checks if the length of the filename is within legal limits. */
-bool check_filename(const char *file)
+/* copies the user file name FILE into NAME, which holds NAME_BUF bytes, and checks that its length is within legal limits. */
+bool copy_filename(char *name, const char *file)
 {
-	if(!syscall_check_pointer((void *)file,esp))
+	int len=strncpy_from_user(name,file,NAME_BUF);
+	if(len<0)
 		exit(-1);
-	return (strlen(file)>0)&&(strlen(file)<15);
+	return (len>0)&&(len<NAME_BUF);
 }
 
-/* returns of the file_pointer represented by fd. */
+/* returns the file_pointer represented by fd, or NULL if fd is not open. */
 struct file * get_file_pointer(int fd)
 {
-	struct list_elem *e;
-	
-	/* 
-	iterates through the list of file descriptors of the current thread and finds the file pointer associated with FD
-	*/
-	for (e = list_begin(&thread_current()->file_list); e != list_end(&thread_current()->file_list); e = list_next (e))
-	{
-		if(list_entry(e, struct file_elem, elem)->fd==fd)
-			return list_entry(e,struct file_elem,elem)->file_pointer;
-	}
-	
-	/*
-	if the fd is not found in the list, return NULL 
-	*/
-	return NULL;
-}
-struct file_elem * get_file_element(int fd)
-{
-	struct list_elem *e;
-	
-	/* 
-	iterates through the list of file descriptors of the current thread and return file_elem associated with the file.
-	*/
-	for (e = list_begin(&thread_current()->file_list); e != list_end(&thread_current()->file_list); e = list_next (e))
-	{
-		if(list_entry(e, struct file_elem, elem)->fd==fd)
-			return (struct file_elem *)list_entry(e,struct file_elem,elem);
-	}
-	return NULL;
+	struct thread *t = thread_current();
+	if(fd < FD_MIN || fd >= t->fd_cnt)
+		return NULL;
+	return t->fd_table[fd];
 }
 
 
 /* creates a file with the filename provided. */
 bool create (const char *file, unsigned initial_size)
 {
-	if(!check_filename(file))
+	char name[NAME_BUF];
+	if(!copy_filename(name,file))
 		return false;
-	return filesys_create(file, initial_size);
+	return filesys_create(name, initial_size);
 }
 
 /* removes the file with the filename provided. */
 bool remove (const char *file)
 {
-	if(!check_filename(file))
+	char name[NAME_BUF];
+	if(!copy_filename(name,file))
 		return false;
-	struct file *f=filesys_open(file);
+	struct file *f=filesys_open(name);
 	if(!f)
 		return false;
 	file_close(f);
-	return filesys_remove(file);
+	return filesys_remove(name);
 }
 
 /* 
@@ -214,42 +390,26 @@ This function opens the file with the given filename by allocating a fd for the
 */
 int open (const char *file)
 {
-	if(!check_filename(file))
+	char name[NAME_BUF];
+	if(!copy_filename(name,file))
 		return -1;
-	struct file *f=filesys_open (file);
+	struct file *f=filesys_open (name);
 	if(!f)
 		return -1;
 	
-	struct file_elem *temp=(struct file_elem *)malloc(sizeof (struct file_elem));
-	int id=thread_current()->FD_CURRENT;
-	thread_current()->FD_CURRENT++;
-	temp->fd=id;
-	temp->file_pointer=f;
 	
-	/* push the file element object into the current thread's file_list. */
-	list_push_back(&thread_current()->file_list,&temp->elem);
+	/* install the file in the lowest free slot of the current thread's descriptor table. */
+	int id=fd_alloc(thread_current(),f);
+	if(id<0)
+		file_close(f);
 	return id;
 }
 
 /* exit system call. calls user_process_exit(status) defined in process.c */
 void exit (int status)
 {
-	struct thread *t = thread_current();
-	struct list_elem *e = list_begin (&t->supp_page_table);
-	while (e != list_end (&t->supp_page_table))
-	{
-	  struct supp_page_table_entry *curr = list_entry(e,struct supp_page_table_entry,elem);
-	  if(curr->mmaped_id)
-	  {
-	  	if(pagedir_is_dirty(t->pagedir,curr->upage))
-	  	{
-	  		file_seek(curr->mmaped_file,(int)curr->ofs);
-	  		file_write(curr->mmaped_file,curr->upage,PGSIZE);
-	  	}
-	 }
-	  e = list_remove(e);
-	  free(curr);
-	}
+	/* the files must be up to date before the parent hears about the exit. process_exit() frees the rest. */
+	mmap_write_back(thread_current(), true, 0);
 	user_process_exit(status);
 	thread_exit();
 }
@@ -257,7 +417,7 @@ void exit (int status)
 /* write system call */
 int write (int fd, const void *buffer, unsigned size)
 {
-	if(!syscall_check_pointer((void *)buffer,esp))
+	if(!check_user_buffer(buffer,size,false))
 		exit(-1);
 		
 	/* In case of writing to STDOUT, call stdout_write() */
@@ -278,7 +438,7 @@ int write (int fd, const void *buffer, unsigned size)
 /* read system call. performs read from the input stream. */
 int read (int fd, void *buffer, unsigned size)
 {
-	if(!syscall_check_pointer(buffer,esp)||fd==STDOUT_FILENO)
+	if(!check_user_buffer(buffer,size,true)||fd==STDOUT_FILENO)
 	{	
 		//printf("problem here \n");
 		exit(-1);
@@ -303,13 +463,220 @@ int read (int fd, void *buffer, unsigned size)
 	return read;
 }
 
+/* 
+pread system call. reads from the file indicated by fd at the given offset, without using or moving its position, 
+so that several processes or threads can share one open file. the console has no positions to read at.
+*/
+int pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+	if(!check_user_buffer(buffer,size,true))
+		exit(-1);
+	struct file *f=get_file_pointer(fd);
+	if(!f||(off_t)offset<0)
+		return -1;
+	return file_read_at(f,buffer,size,offset);
+}
+
+/* pwrite system call. writes to the file indicated by fd at the given offset, without using or moving its position. */
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+	if(!check_user_buffer(buffer,size,false))
+		exit(-1);
+	struct file *f=get_file_pointer(fd);
+	if(!f||(off_t)offset<0)
+		return -1;
+	return file_write_at(f,buffer,size,offset);
+}
+
+/* 
+performs readv (if WRITE is false) or writev on the iovcnt buffers described by the user array iov, one buffer at a 
+time through read() or write(). stops early at a short transfer, like a read that reaches the end of the file. 
+returns the total number of bytes transferred, or -1 if the request is invalid or the first transfer fails.
+*/
+static int vectored_io (int fd, const struct iovec *iov, int iovcnt, bool write_)
+{
+	if(iovcnt<0||iovcnt>IOV_MAX)
+		return -1;
+	struct iovec *vec=malloc(iovcnt*sizeof *vec);
+	if(!vec&&iovcnt>0)
+		return -1;
+	if(!copy_from_user(vec,iov,iovcnt*sizeof *vec))
+	{
+		free(vec);
+		exit(-1);
+	}
+
+	/* the total must fit in the return value. */
+	unsigned total=0;
+	int i;
+	for(i=0;i<iovcnt;i++)
+	{
+		if(vec[i].iov_len>(unsigned)INT_MAX-total)
+		{
+			free(vec);
+			return -1;
+		}
+		total+=vec[i].iov_len;
+	}
+
+	int done=0;
+	for(i=0;i<iovcnt;i++)
+	{
+		int n=write_?write(fd,vec[i].iov_base,vec[i].iov_len):read(fd,vec[i].iov_base,vec[i].iov_len);
+		if(n<0)
+		{
+			if(done==0)
+				done=-1;
+			break;
+		}
+		done+=n;
+		if((unsigned)n<vec[i].iov_len)
+			break;
+	}
+	free(vec);
+	return done;
+}
+
+/* readv system call. */
+int readv (int fd, const struct iovec *iov, int iovcnt)
+{
+	return vectored_io(fd,iov,iovcnt,false);
+}
+
+/* writev system call. */
+int writev (int fd, const struct iovec *iov, int iovcnt)
+{
+	return vectored_io(fd,iov,iovcnt,true);
+}
+
+/* 
+ring_setup system call. maps a zeroed page holding a struct sys_ring at the page-aligned user address addr, which 
+must not be in use. the page is left out of the frame table, so it is never evicted and the kernel can use it through 
+its own mapping without checking user addresses. it is freed with the rest of the page directory at exit.
+*/
+int ring_setup (void *addr)
+{
+	struct thread *t = thread_current();
+	if(t->ring || pg_ofs(addr) != 0 || !check_pointer_unmapped(addr) || pagedir_get_page(t->pagedir, addr))
+		return -1;
+	struct list_elem *e;
+	for (e = list_begin (&t->supp_page_table); e != list_end (&t->supp_page_table); e = list_next (e))
+		if(list_entry(e,struct supp_page_table_entry,elem)->upage == addr)
+			return -1;
+
+	void *kpage = get_page(PAL_USER|PAL_ZERO);
+	if(!kpage)
+		return -1;
+	if(!pagedir_set_page(t->pagedir, addr, kpage, true))
+	{
+		palloc_free_page(kpage);
+		return -1;
+	}
+	t->ring = kpage;
+	t->ring_addr = addr;
+	return 0;
+}
+
+/* 
+gives thread t, which is being forked from thread parent and is running on its own page directory, a copy of 
+parent's system call ring, if it has one, mapped at the same user address. the ring is not in the frame table, so 
+copying the address space leaves it out. returns false if out of memory.
+*/
+bool fork_ring (struct thread *t, struct thread *parent)
+{
+	if(!parent->ring)
+		return true;
+	void *kpage = get_page(PAL_USER);
+	if(!kpage)
+		return false;
+	if(!pagedir_set_page(t->pagedir, parent->ring_addr, kpage, true))
+	{
+		palloc_free_page(kpage);
+		return false;
+	}
+	page_copy(kpage, parent->ring);
+	t->ring = kpage;
+	t->ring_addr = parent->ring_addr;
+	return true;
+}
+
+/* carries out one ring request, through the system call it names. */
+static int ring_op (const struct ring_sqe *sqe)
+{
+	switch(sqe->opcode)
+	{
+		case RING_OP_READ:		return read(sqe->fd,sqe->addr,sqe->len);
+		case RING_OP_WRITE:		return write(sqe->fd,sqe->addr,sqe->len);
+		case RING_OP_PREAD:		return pread(sqe->fd,sqe->addr,sqe->len,sqe->offset);
+		case RING_OP_PWRITE:	return pwrite(sqe->fd,sqe->addr,sqe->len,sqe->offset);
+		case RING_OP_SEEK:		seek(sqe->fd,sqe->offset);					return 0;
+		case RING_OP_CREATE:	return create(sqe->addr,sqe->len);
+		case RING_OP_OPEN:		return open(sqe->addr);
+		case RING_OP_CLOSE:		close(sqe->fd);								return 0;
+		default:				return -1;
+	}
+}
+
+/* 
+ring_enter system call. carries out up to to_submit queued ring requests in order, posting a completion for each, 
+and stops early when the submission queue is empty or the completion queue is full. returns the number of requests 
+taken, or -1 if there is no ring. the requests run here rather than on a system_wq worker because they go through 
+the caller's file descriptors and read and write its address space, which only the caller's own thread has.
+*/
+int ring_enter (unsigned to_submit)
+{
+	struct sys_ring *ring = thread_current()->ring;
+	if(!ring)
+		return -1;
+	unsigned done;
+	for(done = 0; done < to_submit; done++)
+	{
+		unsigned head = ring->sq_head;
+		if(head == ring->sq_tail || ring->cq_tail - ring->cq_head >= RING_ENTRIES)
+			break;
+		
+		/* take a copy, so that the program can't change the request while it is carried out. */
+		struct ring_sqe sqe = ring->sq[head % RING_ENTRIES];
+		ring->sq_head = head + 1;
+		int res = ring_op(&sqe);
+		
+		struct ring_cqe *cqe = &ring->cq[ring->cq_tail % RING_ENTRIES];
+		cqe->user_data = sqe.user_data;
+		cqe->res = res;
+		ring->cq_tail++;
+	}
+	return done;
+}
+
+/* fork system call, which needs the caller's interrupt frame. returns the child's pid to the parent; the child 
+returns 0 from the same call. */
+int sys_fork (struct intr_frame *f)
+{
+	tid_t tid = process_fork(f);
+	return tid != TID_ERROR ? tid : -1;
+}
+
 /* performs the exec system call. */
 int exec (const char *cmd_line)
 {
-	if(!syscall_check_pointer((void *)cmd_line,esp))
+	/* copy the command line into the kernel before anything else looks at it. */
+	char *cmd=get_page(0);
+	if(!cmd)
+		return -1;
+	int len=strncpy_from_user(cmd,cmd_line,PGSIZE);
+	if(len<0)
+	{
+		palloc_free_page(cmd);
 		exit(-1);
+	}
+	if(len==PGSIZE)
+	{
+		palloc_free_page(cmd);
+		return -1;
+	}
 	//printf("cmd '%s'\n",cmd_line);
-	int t=process_execute(cmd_line);
+	int t=process_execute(cmd);
+	palloc_free_page(cmd);
 	//printf("and tid %d\n",t);
 	if(t!=TID_ERROR)
 		return t;
@@ -355,15 +722,31 @@ int wait (int pid)
 	return process_wait(pid);
 }
 
+/* waits for any child to complete, and stores its exit status in *status unless status is NULL. returns its pid, or 
+-1 if there is none. */
+pid_t waitany (int *status)
+{
+	int exit_code;
+	if(status && !check_user_buffer(status,sizeof *status,true))
+		exit(-1);
+	tid_t tid = process_wait_any(&exit_code);
+	if(tid == TID_ERROR)
+		return -1;
+	if(status && !copy_to_user(status,&exit_code,sizeof exit_code))
+		exit(-1);
+	return tid;
+}
+
 /* closes the opened file. */
 void close (int fd)
 {
-	struct file_elem *ele=get_file_element(fd);
-	if(!ele)
+	struct thread *t = thread_current();
+	struct file *f=get_file_pointer(fd);
+	if(!f)
 		return;
-	file_close(ele->file_pointer);
-	list_remove(&ele->elem);
-	free(ele);
+	file_close(f);
+	t->fd_table[fd]=NULL;
+	bitmap_reset(t->fd_map,fd);
 }
 
 mapid_t mmap (int fd, void *addr)
@@ -385,9 +768,12 @@ mapid_t mmap (int fd, void *addr)
 	        }
 		}
 		struct file *mmapedf = file_reopen(f);
+		
+		/* FDs are reused after close, so mappings get ids of their own. */
+		mapid_t mapid = t->mapid_next++;
 		for(i = 0; i < total_pages_needed; i++)
 		{
-			struct supp_page_table_entry *curr = malloc(sizeof(struct supp_page_table_entry));
+			struct supp_page_table_entry *curr = slab_alloc(&supp_page_cache);
 			curr->upage = addr + i*PGSIZE;
 			int left_to_read = filesize(fd) - i * PGSIZE;
 			int read = left_to_read < PGSIZE ? left_to_read : PGSIZE;
@@ -396,36 +782,65 @@ mapid_t mmap (int fd, void *addr)
 			curr->ofs = i*PGSIZE;
 			curr->writable = true;
 			curr->mmaped_file = mmapedf;
-			curr->mmaped_id = fd;
+			curr->mmaped_id = mapid;
 			list_push_back(&t->supp_page_table,&curr->elem);
 			//printf("mmap -- %d entry with %d read bytes and %d zero bytes. filesize is %d.\n",i,read,PGSIZE - read,filesize(fd));
 		}
-		return fd;
+		return mapid;
 	}
 	else return -1;
 	
 }
 
+/* 
+writes the dirty pages of thread t's mapping mapid, or of all its mappings if all is true, back to their files. each 
+run of dirty pages that follow on from each other both in memory and in the file goes out in a single write. 
+*/
+static void mmap_write_back (struct thread *t, bool all, mapid_t mapid)
+{
+	struct list_elem *e = list_begin (&t->supp_page_table);
+	while (e != list_end (&t->supp_page_table))
+	{
+		struct supp_page_table_entry *first = list_entry(e,struct supp_page_table_entry,elem);
+		e = list_next(e);
+		if(!first->mmaped_file || (!all && first->mmaped_id != mapid) || !pagedir_is_dirty(t->pagedir,first->upage))
+			continue;
+		
+		/* only the last page of a mapping can be partial, and nothing follows on from it. */
+		struct supp_page_table_entry *last = first;
+		off_t size = first->page_read_bytes;
+		for (; e != list_end (&t->supp_page_table); e = list_next(e))
+		{
+			struct supp_page_table_entry *next = list_entry(e,struct supp_page_table_entry,elem);
+			if(next->mmaped_file != first->mmaped_file || next->upage != last->upage + PGSIZE
+			   || next->ofs != last->ofs + PGSIZE || last->page_read_bytes != PGSIZE
+			   || !pagedir_is_dirty(t->pagedir,next->upage))
+				break;
+			size += next->page_read_bytes;
+			last = next;
+		}
+		file_write_at(first->mmaped_file, first->upage, size, first->ofs);
+	}
+}
+
 void munmap (mapid_t mapid)
 {
 	struct thread *t = thread_current();
+	mmap_write_back(t, false, mapid);
+	
+	/* the pages of a mapping are adjacent and share one file, which is closed with the last of them. */
 	struct list_elem *e = list_begin (&t->supp_page_table);
 	while (e != list_end (&t->supp_page_table))
 	{
 	  struct supp_page_table_entry *curr = list_entry(e,struct supp_page_table_entry,elem);
-	  if(curr->mmaped_id == mapid)
+	  if(curr->mmaped_file && curr->mmaped_id == mapid)
 	  {
-	  	if(pagedir_is_dirty(t->pagedir,curr->upage))
-	  	{
-	  		file_seek(curr->mmaped_file,(int)curr->ofs);
-	  		file_write(curr->mmaped_file,curr->upage,PGSIZE);
-	  	}
-	  	void *kpage =  pagedir_get_page(t->pagedir,curr->upage);
-	  	palloc_free_page(kpage);
-	  	pagedir_clear_page(t->pagedir,curr->upage);
-	  	file_close(curr->mmaped_file);
+	  	process_drop_page(t, curr->upage);
 	  	e = list_remove(e);
-	  	free(curr);
+	  	if(e == list_end (&t->supp_page_table) 
+	  	   || list_entry(e,struct supp_page_table_entry,elem)->mmaped_file != curr->mmaped_file)
+	  		file_close(curr->mmaped_file);
+	  	slab_free(&supp_page_cache, curr);
 	  }
 	  else e = list_next(e);
 	}
@@ -435,28 +850,35 @@ void munmap (mapid_t mapid)
 void
 syscall_init (void) 
 {
+	ASSERT (sizeof (struct sys_ring) <= PGSIZE);
 	intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 static void
 syscall_handler (struct intr_frame *f UNUSED) 
 {
-	int i=0;
-	if(!syscall_check_pointer(f->esp,(char*)f->esp))
-		exit(-1);
-	esp = (char*) f->esp;
-	/* finds the system call number by dereferencing the stack pointer. */
-	int syscall_num = *(int *)f->esp;
+	/* the page fault handler checks kernel accesses to user memory against the user stack pointer. */
+	thread_current()->syscall_esp = f->esp;
 	
-	/* finds the number of arguments required by the system call. */
-	int num_arguments=num_args[syscall_num];
-	unsigned int arguments[num_arguments];
-	for(i=0;i<num_arguments;i++)
+	/* gives back the trap flag that the debug exception handler cleared in sysenter_entry, so that
+	   the caller takes its single-step trap in user mode once the system call returns. */
+	if(thread_current()->sysenter_step)
 	{
-		if(!syscall_check_pointer(f->esp + (4*(i+1)),esp))
-			exit(-1);
-		arguments[i]=*((unsigned int *)(f->esp + (4*(i+1))));
+		thread_current()->sysenter_step = false;
+		f->eflags |= FLAG_TF;
 	}
 	
+	/* finds the system call number by dereferencing the stack pointer. */
+	unsigned int syscall_num;
+	if(!copy_from_user(&syscall_num, f->esp, sizeof syscall_num)
+	   || syscall_num >= sizeof num_args / sizeof *num_args)
+		exit(-1);
+	
+	/* copies in the number of arguments required by the system call. */
+	int num_arguments=num_args[syscall_num];
+	unsigned int arguments[4];
+	if(!copy_from_user(arguments, (unsigned int *) f->esp + 1, num_arguments * sizeof *arguments))
+		exit(-1);
+	
 	//printf("syscall number %d arguments %d\n",syscall_num,num_arguments);
 	
 	/* calls the appropriate system call. */
@@ -480,6 +902,15 @@ syscall_handler (struct intr_frame *f UNUSED)
 		case 12:	close((int)arguments[0]);												return;
 		case 13:	f->eax=mmap((int)arguments[0],(void*)arguments[1]); 					return;
 		case 14:	munmap((mapid_t)arguments[0]);											return;
+
+		case 20:	f->eax=pread((int)arguments[0],(void *)arguments[1],arguments[2],arguments[3]);			return;
+		case 21:	f->eax=pwrite((int)arguments[0],(const void *)arguments[1],arguments[2],arguments[3]);	return;
+		case 22:	f->eax=readv((int)arguments[0],(const struct iovec *)arguments[1],(int)arguments[2]);	return;
+		case 23:	f->eax=writev((int)arguments[0],(const struct iovec *)arguments[1],(int)arguments[2]);	return;
+		case 24:	f->eax=ring_setup((void *)arguments[0]);												return;
+		case 25:	f->eax=ring_enter(arguments[0]);														return;
+		case 26:	f->eax=sys_fork(f);																		return;
+		case 27:	f->eax=waitany((int *)arguments[0]);													return;
 		default:	break;
 	};
 	exit(-1);
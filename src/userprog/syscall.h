@@ -2,12 +2,16 @@
 #define USERPROG_SYSCALL_H
 #include <list.h>
 
+struct thread;
+
 void syscall_init (void);
 void exit (int status);
-struct file_elem
-{
-	int fd;
-	struct file *file_pointer;
-	struct list_elem elem;
-};
+bool syscall_check_pointer(void *ptr, char *esp_ptr);
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+bool check_user_buffer (const void *uaddr, size_t size, bool write);
+void close_files (struct thread *t);
+bool fork_files (struct thread *t, struct thread *parent);
+bool fork_ring (struct thread *t, struct thread *parent);
 #endif /* userprog/syscall.h */
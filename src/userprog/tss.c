@@ -75,6 +75,24 @@ struct tss
 /* Kernel TSS. */
 static struct tss *tss;
 
+/* Model-specific registers that configure SYSENTER.  See
+   [IA32-v2b] "SYSENTER--Fast System Call". */
+#define MSR_SYSENTER_CS  0x174  /* Kernel code selector. */
+#define MSR_SYSENTER_ESP 0x175  /* Kernel stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* Kernel entry point. */
+
+/* CPUID function 1 EDX bit for SYSENTER and SYSEXIT. */
+#define CPUID_SEP (1 << 11)
+
+/* Entry point for SYSENTER, in sysenter.S. */
+void sysenter_entry (void);
+
+/* True if tss_init() set up SYSENTER. */
+static bool sysenter_enabled;
+
+static bool sysenter_supported (void);
+static void wrmsr (uint32_t msr, uint32_t value);
+
 /* Initializes the kernel TSS. */
 void
 tss_init (void) 
@@ -85,6 +103,13 @@ tss_init (void)
   tss = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   tss->ss0 = SEL_KDSEG;
   tss->bitmap = 0xdfff;
+
+  if (sysenter_supported ()) 
+    {
+      wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+      wrmsr (MSR_SYSENTER_EIP, (uint32_t) sysenter_entry);
+      sysenter_enabled = true;
+    }
   tss_update ();
 }
 
@@ -97,10 +122,44 @@ tss_get (void)
 }
 
 /* Sets the ring 0 stack pointer in the TSS to point to the end
-   of the thread stack. */
+   of the thread stack.
+
+   SYSENTER takes its stack pointer from an MSR rather than the
+   TSS, so that has to follow along.  It must be a real stack
+   from the first instruction of sysenter_entry on: a caller
+   with TF set takes a #DB trap there, before any code of ours
+   could switch stacks. */
 void
 tss_update (void) 
 {
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
+  if (sysenter_enabled)
+    wrmsr (MSR_SYSENTER_ESP, (uint32_t) tss->esp0);
+}
+
+/* Returns true if the CPU implements SYSENTER and SYSEXIT.  The
+   user library in lib/user/syscall.c makes the same check to
+   decide whether to use them. */
+static bool
+sysenter_supported (void) 
+{
+  uint32_t eax, ebx, ecx, edx;
+  unsigned family, model, stepping;
+
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  family = (eax >> 8) & 0xf;
+  model = (eax >> 4) & 0xf;
+  stepping = eax & 0xf;
+
+  /* The earliest Pentium Pro steppings set the bit but don't
+     implement the instructions. */
+  return (edx & CPUID_SEP) != 0 && !(family == 6 && model < 3 && stepping < 3);
+}
+
+/* Writes VALUE to model-specific register MSR. */
+static void
+wrmsr (uint32_t msr, uint32_t value) 
+{
+  asm volatile ("wrmsr" : : "c" (msr), "a" (value), "d" (0));
 }